@@ -34,15 +34,511 @@ Items that could be interesting to implement to extend the functionality:
 #ifndef PRINT_TABLE_H
 #define PRINT_TABLE_H
 
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <new>
 #include <string>
+#include <unordered_map>
 #include <vector>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+#define PRINT_TABLE_POSIX
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
+#endif
+
+struct PrintTable;
+struct PrintTableView;
+
+// Number of rows the column types are inferred from
+const size_t PRINT_TABLE_INFERENCE_SAMPLE = 1024;
+
+// 2^12 HyperLogLog registers per column give a standard error of about 1.6% for distinct counts
+const int PRINT_TABLE_HLL_PRECISION = 12;
+
+// Rows are summarized, spilled to disk and compressed this many at a time
+const size_t PRINT_TABLE_CHUNK_ROWS = 4096;
+
+// Bytes before the payload of a log record: its length and checksum as uint32_t, and its kind
+const size_t PRINT_TABLE_LOG_HEADER = 9;
+
+// Identifies a shared memory segment holding a published table
+const uint64_t PRINT_TABLE_SHARED_MAGIC = 0x31656c6261547450ULL;
+
+// Marks a missing row in a PrintTableView, e.g. the right side of an unmatched row in a left join
+const size_t PRINT_TABLE_NO_ROW = size_t(-1);
+
+enum class PrintTableJoinKind
+{
+    Inner,
+    Left
+};
+
+enum class PrintTableIndexKind
+{
+    Hash,  // Point lookups only
+    Sorted // Point lookups and ranges
+};
+
+enum class PrintTableWindow
+{
+    RunningSum, // Sum of the values so far in the partition
+    Rank,       // Rank of the value within the partition, highest first
+    Delta       // Difference to the previous value in the partition
+};
+
+enum class PrintTableVisual
+{
+    None,     // The column shows the result of its window function
+    Bar,      // A bar whose length is the value scaled between the column's min and max
+    Sparkline // The values of the last rows up to this one, each scaled between the column's min and max
+};
+
+enum class PrintTableColumnType
+{
+    Text,
+    Integer,
+    Decimal,
+    Timestamp, // YYYY-MM-DD with an optional time of day, or nanoseconds since the epoch if added with AddTimestampColumn
+    Enum,      // Few distinct values
+    Duration   // Nanoseconds, added with AddDurationColumn
+};
+
+enum class PrintTableAggregate
+{
+    Sum,
+    Count,
+    Min,
+    Max,
+    Average
+};
+
+// A header spanning the columns [firstColumn, firstColumn + numColumns).
+// Level 0 is drawn directly above the column names, level 1 above level 0 and so on.
+struct PrintTableColumnGroup
+{
+    std::string name;
+    size_t firstColumn;
+    size_t numColumns;
+    size_t level;
+};
+
+// Sequence of values stored in blocks of PRINT_TABLE_CHUNK_ROWS that copies share until one of them changes.
+// Copying it costs O(blocks); a block is copied the first time a value in it is changed, inserted or erased while
+// another copy still refers to it. The reference counts are not a lock: copies must not be changed concurrently.
+template <typename T>
+struct PrintTableCowVector
+{
+    std::vector<std::shared_ptr<std::vector<T>>> blocks; // All full but the last
+    size_t start = 0; // Values erased from the front of the first block
+    size_t count = 0;
+
+    size_t Size() const
+    {
+        return count;
+    }
+
+    bool Empty() const
+    {
+        return count == 0;
+    }
+
+    const T& operator[](size_t i) const
+    {
+        const size_t position = start + i;
+        return (*blocks[position / PRINT_TABLE_CHUNK_ROWS])[position % PRINT_TABLE_CHUNK_ROWS];
+    }
+
+    const T& Back() const
+    {
+        return (*this)[count - 1];
+    }
+
+    std::vector<T>& MutableBlock(size_t block)
+    {
+        if (blocks[block].use_count() > 1)
+        {
+            blocks[block] = std::make_shared<std::vector<T>>(*blocks[block]);
+        }
+        return *blocks[block];
+    }
+
+    T& Mutable(size_t i)
+    {
+        const size_t position = start + i;
+        return MutableBlock(position / PRINT_TABLE_CHUNK_ROWS)[position % PRINT_TABLE_CHUNK_ROWS];
+    }
+
+    void PushBack(const T& value)
+    {
+        if (blocks.empty() || blocks.back()->size() == PRINT_TABLE_CHUNK_ROWS)
+        {
+            blocks.push_back(std::make_shared<std::vector<T>>());
+            blocks.back()->reserve(PRINT_TABLE_CHUNK_ROWS);
+        }
+        MutableBlock(blocks.size() - 1).push_back(value);
+        count++;
+    }
+
+    void PopBack()
+    {
+        MutableBlock(blocks.size() - 1).pop_back();
+        count--;
+        if (count == 0)
+        {
+            Clear();
+        }
+        else if (blocks.back()->empty())
+        {
+            blocks.pop_back();
+        }
+    }
+
+    void Insert(size_t i, const T& value)
+    {
+        PushBack(value);
+        for (size_t j = count - 1; j > i; j--)
+        {
+            std::swap(Mutable(j), Mutable(j - 1));
+        }
+    }
+
+    void Erase(size_t i)
+    {
+        for (size_t j = i; j + 1 < count; j++)
+        {
+            std::swap(Mutable(j), Mutable(j + 1));
+        }
+        PopBack();
+    }
+
+    // Erases the first n values, dropping the blocks they filled without copying them
+    void EraseFront(size_t n)
+    {
+        start += n;
+        count -= n;
+        if (count == 0)
+        {
+            return Clear();
+        }
+        const size_t droppedBlocks = start / PRINT_TABLE_CHUNK_ROWS;
+        blocks.erase(blocks.begin(), blocks.begin() + droppedBlocks);
+        start -= droppedBlocks * PRINT_TABLE_CHUNK_ROWS;
+    }
+
+    void Resize(size_t n, const T& value = T())
+    {
+        while (count > n)
+        {
+            PopBack();
+        }
+        while (count < n)
+        {
+            PushBack(value);
+        }
+    }
+
+    void Assign(size_t n, const T& value)
+    {
+        Clear();
+        Resize(n, value);
+    }
+
+    void Clear()
+    {
+        blocks.clear();
+        start = 0;
+        count = 0;
+    }
+};
+
+// Shared pointer to something tied to one table, such as its log. Copies of the table start without it.
+template <typename T>
+struct PrintTableOwnedPtr : std::shared_ptr<T>
+{
+    PrintTableOwnedPtr() = default;
+    PrintTableOwnedPtr(const PrintTableOwnedPtr&) : std::shared_ptr<T>()
+    {
+    }
+    PrintTableOwnedPtr(PrintTableOwnedPtr&&) = default;
+    PrintTableOwnedPtr& operator=(PrintTableOwnedPtr&&) = default;
+
+    PrintTableOwnedPtr& operator=(const PrintTableOwnedPtr& other)
+    {
+        if (this != &other)
+        {
+            this->reset();
+        }
+        return *this;
+    }
+
+    PrintTableOwnedPtr& operator=(std::shared_ptr<T> other)
+    {
+        std::shared_ptr<T>::operator=(std::move(other));
+        return *this;
+    }
+};
+
+// Posting lists of the rows containing each trigram (three consecutive bytes) in the indexed columns.
+// The index is built on the first search that can use it and then kept up to date as rows are added.
+struct PrintTableTrigramIndex
+{
+    std::vector<size_t> columns;
+    bool enabled = false;
+    bool built = false;
+    std::unordered_map<uint32_t, std::vector<uint32_t>> postings;
+};
+
+// Maps the values of a column to the rows holding them, kept up to date as rows are added and changed
+struct PrintTableColumnIndex
+{
+    size_t column;
+    PrintTableIndexKind kind;
+    std::unordered_map<std::string, std::vector<size_t>> hash;
+    std::multimap<std::string, size_t> sorted;
+    bool numeric = false; // Sorted on the numbers of a column with typed storage in sortedNumbers instead of on text
+    int scale = 0;        // The numbers are multiplied by 10^scale
+    std::multimap<int64_t, size_t> sortedNumbers;
+};
+
+// Part of the spill file mapped into memory, unmapped when the last chunk using it is destroyed
+struct PrintTableSpillMapping
+{
+    void* base = nullptr;
+    size_t length = 0;
+    ~PrintTableSpillMapping();
+};
+
+// PRINT_TABLE_CHUNK_ROWS cells of a column that were sealed: spilled to disk, or compressed in memory.
+// Both are read in the same layout: typed cells as one int64_t per row, text as PRINT_TABLE_CHUNK_ROWS + 1
+// uint32_t offsets followed by the cells. Null cells are empty, their validity bits stay in memory.
+struct PrintTableSealedChunk
+{
+    std::shared_ptr<PrintTableSpillMapping> mapping;
+    const char* data = nullptr; // In the mapping if spilled, nullptr if compressed
+    std::shared_ptr<const std::string> compressed; // Shared by copies of the table
+    bool typed = false;
+    PrintTableColumnType type = PrintTableColumnType::Text;
+    int scale = 0;
+};
+
+// Cells of a column frozen by PrintTable::Freeze, with their texts back to back in one blob. Columns with few
+// distinct cells store each distinct text once and a code per cell instead.
+struct PrintTableFrozenCells
+{
+    std::string blob;
+    std::vector<uint32_t> offsets; // Start of each text in blob, followed by the end of blob
+    std::vector<uint16_t> codes;   // Text of each cell that is not null, empty unless dictionary encoded
+};
+
+enum class PrintTableLogRecord : unsigned char
+{
+    Schema = 1, // Title, the name and kind of each column, and the null marker
+    Row,        // The cells as they were added, null cells marked as such
+    Types,      // The types inferred for the columns, so they do not depend on how the rows were batched
+    Cell,       // A changed cell
+    Widths      // Max cell width per column of a completed chunk
+};
+
+// Append-only file of checksummed records a persistent table is rebuilt from, see PrintTable::OpenLog.
+// The file is mapped into memory, grown and remapped when full, and cut back to its records when closed.
+struct PrintTableLog
+{
+    int fd = -1;
+    char* base = nullptr;
+    size_t capacity = 0;          // Bytes mapped
+    size_t length = 0;            // Bytes of records
+    size_t syncRecords = 0;       // Records appended between fdatasync calls
+    size_t unsyncedRecords = 0;
+    bool loggedSchema = false;
+    bool loggedTypes = false;
+    size_t loggedWidthChunks = 0; // Widths records are logged for the chunks before this one
+    ~PrintTableLog();
+};
+
+// Start of a shared memory segment a table is published in, see PrintTable::Publish. It is followed by the schema
+// and the max cell width of each column, then by blocks of rows in the order they were published. A block holds its
+// number of rows as uint64_t and the printed cells column by column, each as uint32_t offsets followed by the text.
+// Published rows are never overwritten, unless a published cell changes and the segment is rebuilt in a new epoch.
+struct PrintTableSharedHeader
+{
+    uint64_t magic = PRINT_TABLE_SHARED_MAGIC;
+    std::atomic<uint64_t> sequence; // Odd while the header, schema or widths change, readers retry if it changed
+    std::atomic<uint64_t> epoch;    // Incremented before published rows are overwritten
+    uint64_t numRows = 0;
+    uint64_t firstBlock = 0;
+    uint64_t length = 0;            // End of the last block
+};
+
+// Writer side of a table published in shared memory
+struct PrintTablePublication
+{
+    std::string name;
+    char* base = nullptr;
+    size_t capacity = 0;
+    size_t publishedRows = 0;
+    std::string schema;      // As it was last published or tried to be, the segment is rebuilt if it changes
+    std::vector<int> widths;
+    bool stale = false;      // Set if a published cell changed, or the rows must be compacted to fit
+    bool full = false;       // Set if the rows with schema did not fit in one block, until a cell changes
+    ~PrintTablePublication(); // Unmaps and unlinks the segment, readers that mapped it keep their mapping
+};
+
+// A render of a table kept up to date in two buffers allocated up front, for PrintTable::PrintEmergency to write from
+// a signal handler. Both slots hold the same render between updates: an update changes the slot that is not active,
+// makes it the active one, and then repeats the change on the other, so the active slot never changes under a handler.
+struct PrintTableEmergency
+{
+    int fd = 2;
+    std::vector<char> slots[2];
+    size_t lengths[2] = { 0, 0 };
+    std::atomic<int> active{ 0 };
+    std::string header;              // Everything before the first row, as it was rendered
+    uint64_t formatKey = 0;          // rowFormatKey the rows were rendered with
+    std::vector<size_t> rowOffsets;  // Where each rendered row starts, followed by where the bottom divider starts
+    size_t renderedRows = 0;         // Rows that were rendered, or left out because they did not fit
+    std::vector<size_t> changedRows; // Rendered rows with cells that changed since the last update
+    bool stale = true;               // Set if the render must be rebuilt from scratch
+    bool truncated = false;
+};
+
+// The cells of a single column, one per row
+struct PrintTableColumn
+{
+    PrintTableCowVector<std::string> cells; // Cells that are not null, empty if the column has typed storage
+    PrintTableColumnType type = PrintTableColumnType::Text;
+    bool typedStorage = false;      // Cells are stored in numbers, multiplied by 10^scale, instead of in cells
+    PrintTableCowVector<int64_t> numbers;
+    int scale = 0;
+    PrintTableCowVector<uint64_t> validity; // One bit per row, set if the cell is not null. Empty until the first null.
+    PrintTableCowVector<size_t> validBefore; // Number of cells that are not null before each word of validity
+    size_t nullCount = 0;
+    int fractionDigits = 0;    // Of the seconds of a timestamp column
+    int64_t utcOffset = 0;     // In nanoseconds, added to timestamps before formatting them
+    mutable int64_t cachedMinute = INT64_MIN;
+    mutable std::string cachedPrefix; // "YYYY-MM-DD HH:MM:" of cachedMinute, shared by consecutive timestamps
+    std::vector<PrintTableSealedChunk> sealedChunks; // The oldest rows, which are no longer in cells or numbers
+    size_t sealedRows = 0;
+    size_t sealedValues = 0; // Cells that are not null among the sealed rows
+    mutable size_t decompressedChunk = size_t(-1);
+    mutable std::string decompressed; // Layout of the compressed chunk read last, so consecutive rows share it
+    int maxCellWidth = 0; // Max over the chunks of the table, kept up to date as cells are added
+    std::shared_ptr<const PrintTableFrozenCells> frozen; // Holds all cells once the table is frozen, shared by copies
+};
+
+// Summary of PRINT_TABLE_CHUNK_ROWS consecutive rows. Column widths are a reduction over the chunks, changing a cell
+// only invalidates the chunk it is in, and a chunk keeps its formatted rows until its content or the row format changes.
+struct PrintTableChunk
+{
+    std::vector<int> maxCellWidths;  // Per column
+    std::vector<size_t> bytes;       // Estimated memory taken up by the resident cells, per column
+    uint64_t fingerprint = 0;        // Sum of PrintTableRowsFingerprintTerm over the rows
+    bool widthsDirty = false;        // Set if a cell as long as its column's max width was shortened
+    std::shared_ptr<std::vector<std::string>> rowStrs; // Shared by copies of the table until either reformats the chunk
+    uint64_t formattedKey = 0;       // fingerprint combined with the row format rowStrs were built with
+    bool hasRowStrs = false;
+};
+
+// A column whose values are computed from other columns by a window function, or drawn from them as a visual.
+// Values are stored as numbers and only formatted when printed. Running sums, deltas and visuals are extended
+// as rows are appended in order, anything else marks the column dirty so it is recomputed with one sorted pass.
+struct PrintTableComputedColumn
+{
+    struct PartitionState
+    {
+        double sum;
+        double last;
+        bool hasLast; // Whether last holds a value, deltas start after the first number of a partition
+        std::string lastOrderKey;
+    };
+
+    std::string name;
+    PrintTableWindow function;
+    size_t valueColumn;
+    int orderColumn;     // -1 to use the order in which rows were added
+    int partitionColumn; // -1 for a single partition
+    PrintTableVisual visual = PrintTableVisual::None;
+    int width = 0;                   // Number of characters a visual takes up, independent of the values
+    std::vector<std::string> glyphs; // Bars: the bar for each fill level in eighths. Sparklines: one glyph per level.
+    mutable double minValue;
+    mutable double maxValue;
+    mutable std::vector<double> values;
+    mutable std::vector<bool> valid; // False if the value could not be computed, e.g. the delta of the first row
+    mutable int maxCellWidth = 0;    // Of the formatted values, kept up to date as values are appended or recomputed
+    mutable bool dirty = true;
+    mutable uint64_t evaluations = 0; // Number of times all values were recomputed, which can change any formatted row
+    mutable std::unordered_map<std::string, PartitionState> partitions;
+};
+
+// Approximate statistics of a column, updated as rows are added in memory that does not grow with the table:
+// a HyperLogLog sketch for the number of distinct values and Space-Saving counters for the most frequent values
+struct PrintTableColumnStats
+{
+    struct Counter
+    {
+        std::string value;
+        uint64_t count; // Overestimates the true count by at most error
+        uint64_t error;
+    };
+
+    std::vector<uint8_t> registers;
+    std::vector<Counter> counters;
+    std::unordered_map<std::string, size_t> counterIndices;
+};
 
 struct PrintTable
 {
     //Base data
     std::string title;
     std::vector<std::string> columnNames;
-    std::vector<std::vector<std::string>> rows;
+    std::vector<PrintTableColumnGroup> columnGroups;
+    std::vector<PrintTableColumn> columns; // One per column name, storing the table column by column
+    std::vector<PrintTableComputedColumn> computedColumns; // Printed after the regular columns
+    size_t numRows = 0;
+    bool typesInferred = false;
+    bool cellWidthsDirty = false;          // Set if a chunk has widthsDirty set
+    std::vector<PrintTableChunk> chunks;
+    PrintTableCowVector<uint64_t> rowFingerprints; // Hash of the cells of each row
+    uint64_t rowsFingerprint = 0;          // Order dependent combination of rowFingerprints, updated as rows are added
+    mutable PrintTableTrigramIndex trigramIndex;
+    std::vector<PrintTableColumnIndex> columnIndexes;
+    std::vector<PrintTableColumnStats> columnStats; // Empty unless enabled with EnableColumnStats
+    size_t statsTopN = 0;
+    std::string nullText = "-";             // Printed in place of null cells
+    std::string nullMarker;                 // Added cells equal to this are stored as null, if hasNullMarker
+    bool hasNullMarker = false;
+    size_t memoryBudget = 0;  // Bytes the resident cells may take up before the oldest rows are spilled, unlimited if 0
+    size_t residentBytes = 0; // Estimate of the bytes taken up by the cells that are not sealed
+    size_t sealedRows = 0;    // Rows [0, sealedRows) are spilled to disk or compressed, and can no longer be changed
+    std::shared_ptr<FILE> spillFile;
+    bool compressColdRows = false;
+    size_t hotRows = 0;       // Newest rows that are not compressed
+    PrintTableOwnedPtr<PrintTableLog> log; // Rows and changed cells are appended to it if set
+    PrintTableOwnedPtr<PrintTablePublication> publication;
+    PrintTableOwnedPtr<PrintTableEmergency> emergency;
+    bool frozen = false;          // Set by Freeze, after which rows can no longer be added or changed
+    bool restoringWidths = false; // Set while rows whose widths are known are added, AppendRowMetadata then leaves them to the caller
     bool startedAddingRows = false;
     bool alteredState = false;
 
@@ -51,196 +547,6108 @@ struct PrintTable
     std::string fullDividerStr;
     std::string titleStr;
     std::string columnStr;
-    std::vector<std::string> rowStrs;
+    std::vector<std::string> columnGroupStrs; // One per group level, top level first
+    uint64_t rowFormatKey = 0; // Hash of the column widths and everything else the row strings depend on besides the cells
+    uint64_t formattedFingerprint = 0; // Fingerprint of the content the format data was built from
+    bool hasFormat = false;
+    uint64_t printedFingerprint = 0;   // Fingerprint of the content last printed
+    bool hasPrinted = false;
+
+    //Functions
+    void SetTitle(const std::string& title);
+    void AddColumn(const std::string& columnName);
+    // Adds a column of nanoseconds since the epoch, printed as "YYYY-MM-DD HH:MM:SS" with fractionDigits (0 to 9)
+    // digits of the seconds, in the time zone utcOffsetMinutes away from UTC
+    void AddTimestampColumn(const std::string& columnName, int fractionDigits = 0, int utcOffsetMinutes = 0);
+    // Adds a column of nanoseconds, printed in ns, us, ms or s, whichever keeps the number below 1000
+    void AddDurationColumn(const std::string& columnName);
+    void AddColumnGroup(const std::string& groupName, size_t firstColumn, size_t numColumns, size_t level = 0);
+    // Adds a row of text. Column types are only inferred by the first AddRows, from up to PRINT_TABLE_INFERENCE_SAMPLE
+    // cells per column, so columns of a table filled by AddRow alone stay text.
+    void AddRow(const std::vector<std::string>& row);
+    void AddRows(const std::vector<std::vector<std::string>>& rows);
+    // Updates the metadata kept for each row after its cells have been appended to columns
+    void AppendRowMetadata(size_t row);
+    // Classifies the columns from a sample of the rows and moves integer and fixed-point columns to typed storage.
+    // Called by AddRows the first time it is used.
+    void InferColumnTypes();
+    // Whether the column holds numbers, which are aligned to the right
+    bool IsNumericColumn(size_t column) const;
+    // Spills the oldest rows to a temporary file, PRINT_TABLE_CHUNK_ROWS at a time, when the cells take up more
+    // than bytes. Spilled rows are read back through mmap and can no longer be changed.
+    void SetMemoryBudget(size_t bytes);
+    // Spills chunks of the oldest rows until the resident cells fit in the memory budget
+    void SpillRows();
+    // Compresses the cells of all but the newest hotRows rows in memory, PRINT_TABLE_CHUNK_ROWS at a time, with
+    // dictionary or delta encoding followed by LZ77. Compressed rows are decompressed when read and can no longer be changed.
+    void EnableCompression(size_t hotRows = PRINT_TABLE_CHUNK_ROWS);
+    // Compresses chunks of the oldest rows until only the newest hotRows rows are left uncompressed
+    void CompressRows();
+    // Moves every column into one blob of text and an offset per cell, or a dictionary of its distinct texts and a
+    // code per cell if that is smaller, and releases the cells, sealed chunks and cached rows. Rows are formatted
+    // from the blobs as they are printed, and can no longer be added or changed.
+    void Freeze();
+    // Makes the table persistent. Rows and changed cells are appended to the log at path, and forced to disk every
+    // syncRecords records. If the log has records, e.g. from a process that crashed, the table is reset and rebuilt
+    // from them first. Must be called before the first row is added. Returns whether the log could be opened.
+    bool OpenLog(const std::string& path, size_t syncRecords = 256);
+    // Forces the records appended to the log so far to disk
+    void SyncLog();
+    void LogRecord(PrintTableLogRecord kind, const std::string& payload);
+    void LogRow(const std::vector<std::string>& row);
+    // Logs the inferred types once they are known, and syncs the log if enough records were appended
+    void CommitLog();
+    // Applies a record read back from the log. Returns false if it does not fit the table.
+    bool ReplayLogRecord(PrintTableLogRecord kind, const unsigned char* data);
+    // Publishes the table in the POSIX shared memory object name, e.g. "/status", of capacity bytes. Another process can
+    // print it with PrintPublished without blocking this one. Rows are appended to it as they are added, computed
+    // columns and column groups are not published. The object is unlinked when the table is reset or destroyed.
+    // Fails if the object already exists, e.g. published by another table or left behind by a process that crashed.
+    bool Publish(const std::string& name, size_t capacity = size_t(1) << 24);
+    // Appends the rows added since the last call to the published segment, or rebuilds it if published cells changed.
+    // The blocks of rows are compacted into one if they run out of room. Returns false if the rows do not fit even
+    // then, in which case the segment keeps the rows published before and later calls try again.
+    bool PublishRows();
+    // Prints a consistent snapshot of the table published as name by another process
+    static bool PrintPublished(const std::string& name);
+    // Allocates two buffers of capacity bytes, to hold the printed table as rows are added and changed from now on,
+    // so PrintEmergency can write it to fd from a signal handler. Rows that do not fit in capacity are left out.
+    // The table stays armed when it is reset.
+    bool ArmEmergencyPrint(int fd = 2, size_t capacity = size_t(1) << 22);
+    // Brings the emergency render up to date with the rows added and changed since the last call
+    void UpdateEmergencyRender();
+    // Writes the table as it was after the last change with write(2) only, which is async-signal-safe. Does nothing
+    // unless armed with ArmEmergencyPrint. The handler must not run on a thread other than the one changing the table.
+    void PrintEmergency() const;
+    // Recomputes the estimate of the memory taken up by the cells that are not sealed
+    void RecountResidentBytes();
+    // Appends the printed row to rowStr, given the formatted cells of its computed columns
+    void AppendRowStr(size_t row, const std::string* computedRow, std::string& rowStr) const;
+    // Speeds up Grep on indexedColumns (all columns if empty) for patterns of at least 3 characters
+    void CreateTrigramIndex(const std::vector<std::string>& indexedColumns = {});
+    void SetCell(size_t row, size_t column, const std::string& value);
+    void SetNull(size_t row, size_t column);
+    // Replaces a cell with value, or with null if value is nullptr
+    void ChangeCell(size_t row, size_t column, const std::string* value);
+    // Sets the text printed in place of null cells, "-" by default
+    void SetNullText(const std::string& text);
+    // Cells equal to marker that are added or set afterwards are stored as null, e.g. "" or "NA"
+    void SetNullMarker(const std::string& marker);
+    // Adds a column computing function over valueColumn, in the order of orderColumn (the order rows
+    // were added in if empty) within groups of rows with the same partitionColumn (one group if empty)
+    void AddWindowColumn(const std::string& name, PrintTableWindow function, const std::string& valueColumn, const std::string& orderColumn = "", const std::string& partitionColumn = "");
+    // Adds a column drawing valueColumn as a bar or sparkline that is width characters wide
+    void AddVisualColumn(const std::string& name, PrintTableVisual visual, const std::string& valueColumn, int width = 10);
+    void EvaluateComputedColumns() const;
+    void CreateIndex(const std::string& column, PrintTableIndexKind kind);
+    // Starts keeping approximate distinct counts and the topN most frequent values of every column
+    void EnableColumnStats(size_t topN = 5);
+    // Builds a table with a row per column showing its approximate distinct count and most frequent values
+    PrintTable Summary() const;
+    // Selects the rows whose cell in column equals value
+    PrintTableView Lookup(const std::string& column, const std::string& value) const;
+    // Selects the rows whose cell in column is in [low, high], ordered by that cell
+    PrintTableView Range(const std::string& column, const std::string& low, const std::string& high) const;
+    // Brings the format data up to date with the content. Returns false if the table is missing data to print.
+    bool BuildFormat();
+    // Returns the printed rows of chunk i, formatting them again only if its cells or the row format changed.
+    // Sealed chunks are formatted into scratch instead of being cached.
+    const std::vector<std::string>& ChunkRowStrs(size_t i, std::vector<std::string>& scratch);
+    void Print();
+    // Prints the table only if its content differs from what was printed last. Returns whether it was printed.
+    bool PrintIfChanged();
+    void Reset();
+    uint64_t Fingerprint() const;
+    size_t NumRows() const;
+    // Number of printed columns, i.e. including the computed columns
+    size_t NumColumns() const;
+    const std::string& ColumnName(size_t column) const;
+    std::string Cell(size_t row, size_t column) const;
+    bool IsNull(size_t row, size_t column) const;
+    // Number of characters the cell takes up when printed
+    int CellWidth(size_t row, size_t column) const;
+    int FindColumn(const std::string& columnName) const;
+    // Selects the rows with a cell in one of searchedColumns (all columns if empty) that contains pattern.
+    // If highlight is set, the matches are highlighted when the view is printed.
+    PrintTableView Grep(const std::string& pattern, const std::vector<std::string>& searchedColumns = {}, bool highlight = false) const;
+    // Runs a query of the form
+    //     select <* | column, ...> [where <condition>] [order by <column> [asc | desc]] [limit <n>]
+    // where a condition compares columns to "strings" or numbers with =, !=, <, <=, > and >=,
+    // combined with and, or and parentheses. Column names that are not identifiers are quoted with `backticks`.
+    // An invalid query selects nothing, and is described in error if given instead of being printed.
+    PrintTableView Query(const std::string& query, std::string* error = nullptr) const;
+
+    // Joins the rows of left and right whose key columns are equal.
+    // The result references the cells of both tables, so they must outlive it and not be modified while it is in use.
+    static PrintTableView Join(const PrintTable& left, const PrintTable& right, const std::vector<std::string>& keyColumns, PrintTableJoinKind kind = PrintTableJoinKind::Inner);
+    // Builds a table with the rows that were added (+), removed (-) or changed (~) between previous and current.
+    // Rows are matched on their key columns, which must be unique. Changed rows only show their key and changed cells.
+    static PrintTable Diff(const PrintTable& previous, const PrintTable& current, const std::vector<std::string>& keyColumns);
+    // Reshapes a long table into a wide one with a row per distinct rowKey and a column per distinct columnKey,
+    // holding the aggregate of valueColumn for that pair. Non-numeric values are only counted.
+    static PrintTable Pivot(const PrintTable& source, const std::string& rowKey, const std::string& columnKey, const std::string& valueColumn, PrintTableAggregate aggregate);
+    // Appends the table to output in a compact binary form holding its column types and widths, which Merge reads back
+    // without parsing or measuring the cells again, e.g. to send a partial table from a worker process through a pipe
+    void Serialize(std::string& output) const;
+    // Combines partial tables written by Serialize that have the same columns. The rows are concatenated in the order
+    // of the parts, or merged by keyColumn if it is not empty, in which case each part must be sorted by it.
+    // Parts that cannot be read or do not match the first one are left out.
+    static PrintTable Merge(const std::vector<std::string>& parts, const std::string& keyColumn = "");
+};
+
+// A table whose cells are references to cells in one or more PrintTables.
+// Column widths are computed from the referenced rows only when printing.
+struct PrintTableView
+{
+    std::string title;
+    std::vector<std::string> columnNames;
+    std::vector<const PrintTable*> tables;
+    std::vector<size_t> columnTables;  // Index into tables for each column
+    std::vector<size_t> columnSources; // Column in the referenced table for each column
+    std::vector<size_t> rowSources;    // tables.size() row indices per row, PRINT_TABLE_NO_ROW if missing
+    std::string highlightPattern;      // Occurrences are highlighted when printing, if not empty
+
+    size_t NumRows() const;
+    std::string Cell(size_t row, size_t column) const;
+    int CellWidth(size_t row, size_t column) const;
+    // Appends the printed view to output
+    void Render(std::string& output) const;
+    void Print() const;
+};
+
+// Renders registered tables for local clients connecting to a Unix domain socket. A client sends one line,
+//     <table>[\t<option>=<value>]...
+// with the options query (see PrintTable::Query), grep (a pattern), rows (<first>:<count>) and format (text or csv),
+// and reads the render until the server closes the connection. Clients are served by Poll, which the thread changing
+// the tables calls from its loop, so renders never race with changes. Sockets are non-blocking, so a slow client
+// cannot stall that thread: whatever it does not take right away is kept and sent by later polls.
+struct PrintTableServer
+{
+    struct Client
+    {
+        std::string request;
+        std::string pending; // Response bytes the socket did not take yet
+        bool responding = false;
+    };
+
+    std::string path;
+    int listenFd = -1;
+    int epollFd = -1; // Only on Linux, other systems poll every socket
+    std::map<std::string, PrintTable*> tables;
+    std::map<int, Client> clients;
+
+    PrintTableServer() = default;
+    PrintTableServer(const PrintTableServer&) = delete;
+    PrintTableServer& operator=(const PrintTableServer&) = delete;
+    ~PrintTableServer();
+
+    // Listens on the socket at path, replacing a stale socket file left there. Returns whether it could listen.
+    bool Listen(const std::string& path);
+    // Serves table as name. The table must outlive the server or be unregistered first.
+    void Register(const std::string& name, PrintTable& table);
+    void Unregister(const std::string& name);
+    // Accepts clients, reads their requests and sends renders, waiting up to timeoutMs (-1 for ever) for activity
+    void Poll(int timeoutMs = 0);
+    // Renders the response to a request line into the client's socket
+    void Respond(int fd, Client& client);
+    void CloseClient(int fd);
+    void Close();
+};
+
+#endif // PRINT_TABLE_H
+
+#ifdef PRINT_TABLE_IMPLEMENTATION
+// Appends "| <text centered in width> " to str, or with text aligned to the right if alignRight is set.
+// textWidth is the number of characters text takes up when printed, which differs from its length
+// if it contains escape sequences.
+static void PrintTableAppendCell(std::string& str, const char* text, size_t length, int width, int textWidth, bool alignRight)
+{
+    const int lengthDiff = width > textWidth ? width - textWidth : 0;
+    // Divide by 2 to get number of pre spaces
+    const int numPreSpace = alignRight ? lengthDiff : lengthDiff / 2;
+    // Divide by 2, but increment lengthDiff by one to round up.
+    // I do this because I want extra spaces after the text
+    const int numPostSpace = lengthDiff - numPreSpace;
+    str += "| ";
+    str.append(numPreSpace, ' ');
+    str.append(text, length);
+    str.append(numPostSpace, ' ');
+    str += " ";
+}
+
+static void PrintTableAppendCell(std::string& str, const std::string& text, int width, int textWidth, bool alignRight = false)
+{
+    PrintTableAppendCell(str, text.data(), text.length(), width, textWidth, alignRight);
+}
+
+static void PrintTableAppendCell(std::string& str, const std::string& text, int width)
+{
+    PrintTableAppendCell(str, text, width, int(text.length()));
+}
+
+// Returns the first occurrence of needle in haystack, or nullptr if there is none.
+// With SSE2 16 positions are tested at a time by comparing the first and last byte of needle,
+// and only positions where both match are verified with memcmp.
+static const char* PrintTableFind(const char* haystack, size_t length, const char* needle, size_t needleLength)
+{
+    if (needleLength == 0)
+    {
+        return haystack;
+    }
+    if (needleLength > length)
+    {
+        return nullptr;
+    }
+    size_t i = 0;
+#ifdef __SSE2__
+    const __m128i first = _mm_set1_epi8(needle[0]);
+    const __m128i last = _mm_set1_epi8(needle[needleLength - 1]);
+    for (; i + needleLength - 1 + 16 <= length; i += 16)
+    {
+        const __m128i blockFirst = _mm_loadu_si128((const __m128i*)(haystack + i));
+        const __m128i blockLast = _mm_loadu_si128((const __m128i*)(haystack + i + needleLength - 1));
+        unsigned int mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(first, blockFirst), _mm_cmpeq_epi8(last, blockLast)));
+        while (mask != 0)
+        {
+            const unsigned int bit = __builtin_ctz(mask);
+            if (memcmp(haystack + i + bit + 1, needle + 1, needleLength - 1) == 0)
+            {
+                return haystack + i + bit;
+            }
+            mask &= mask - 1;
+        }
+    }
+#endif
+    for (; i + needleLength <= length; i++)
+    {
+        if (haystack[i] == needle[0] && memcmp(haystack + i + 1, needle + 1, needleLength - 1) == 0)
+        {
+            return haystack + i;
+        }
+    }
+    return nullptr;
+}
+
+// Wraps every occurrence of pattern in text with escape sequences that print it in bold red
+static std::string PrintTableHighlight(const std::string& text, const std::string& pattern)
+{
+    std::string highlighted;
+    size_t start = 0;
+    const char* match;
+    while ((match = PrintTableFind(text.data() + start, text.length() - start, pattern.data(), pattern.length())) != nullptr)
+    {
+        const size_t offset = match - text.data();
+        highlighted.append(text, start, offset - start);
+        highlighted += "\x1b[1;31m";
+        highlighted.append(text, offset, pattern.length());
+        highlighted += "\x1b[0m";
+        start = offset + pattern.length();
+    }
+    highlighted.append(text, start, std::string::npos);
+    return highlighted;
+}
+
+static uint64_t PrintTableMix(uint64_t x)
+{
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+// Hashes 8 bytes at a time. The length is mixed in, so hashing several strings
+// in a row by chaining the seed does not need separators between them.
+static uint64_t PrintTableHash(const char* data, size_t length, uint64_t seed)
+{
+    uint64_t hash = seed ^ (length * 0x9e3779b97f4a7c15ULL);
+    while (length >= 8)
+    {
+        uint64_t word;
+        memcpy(&word, data, 8);
+        hash = PrintTableMix(hash ^ word);
+        data += 8;
+        length -= 8;
+    }
+    uint64_t tail = 0;
+    memcpy(&tail, data, length);
+    return PrintTableMix(hash ^ tail);
+}
+
+static const int64_t PRINT_TABLE_POWERS_OF_10[19] = { 1LL, 10LL, 100LL, 1000LL, 10000LL, 100000LL, 1000000LL, 10000000LL, 100000000LL, 1000000000LL, 10000000000LL, 100000000000LL, 1000000000000LL, 10000000000000LL, 100000000000000LL, 1000000000000000LL, 10000000000000000LL, 100000000000000000LL, 1000000000000000000LL };
+
+// Checks 16 bytes at a time with SSE2 whether all bytes are ASCII digits
+static bool PrintTableAllDigits(const char* data, size_t length)
+{
+    size_t i = 0;
+#ifdef __SSE2__
+    const __m128i zero = _mm_set1_epi8('0');
+    const __m128i nine = _mm_set1_epi8('9');
+    for (; i + 16 <= length; i += 16)
+    {
+        const __m128i block = _mm_loadu_si128((const __m128i*)(data + i));
+        // Bytes >= 0x80 are negative as signed bytes, so they fail the first comparison
+        const __m128i nonDigits = _mm_or_si128(_mm_cmplt_epi8(block, zero), _mm_cmpgt_epi8(block, nine));
+        if (_mm_movemask_epi8(nonDigits) != 0)
+        {
+            return false;
+        }
+    }
+#endif
+    for (; i < length; i++)
+    {
+        if (data[i] < '0' || data[i] > '9')
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Returns the number of fraction digits if text is a number written exactly as PrintTableFormatScaled would
+// write it (no leading zeros, no '+', no exponent, no negative zero, at most 19 digits), and -1 otherwise
+static int PrintTableCanonicalScale(const std::string& text)
+{
+    const size_t start = !text.empty() && text[0] == '-' ? 1 : 0;
+    const size_t point = text.find('.', start);
+    const size_t integerDigits = (point == std::string::npos ? text.length() : point) - start;
+    const size_t fractionDigits = point == std::string::npos ? 0 : text.length() - point - 1;
+    if (integerDigits == 0 || integerDigits + fractionDigits > 19 || (point != std::string::npos && fractionDigits == 0))
+    {
+        return -1;
+    }
+    if (!PrintTableAllDigits(text.data() + start, integerDigits) || (point != std::string::npos && !PrintTableAllDigits(text.data() + point + 1, fractionDigits)))
+    {
+        return -1;
+    }
+    if (integerDigits > 1 && text[start] == '0')
+    {
+        return -1;
+    }
+    if (start == 1 && text.find_first_not_of("0.", 1) == std::string::npos)
+    {
+        return -1;
+    }
+    return int(fractionDigits);
+}
+
+// Parses text into a number multiplied by 10^scale if it is canonical and has exactly scale fraction digits
+static bool PrintTableParseScaled(const std::string& text, int scale, int64_t& value)
+{
+    if (PrintTableCanonicalScale(text) != scale)
+    {
+        return false;
+    }
+    // 19 digits fit in 64 bits unsigned, but not always signed
+    uint64_t magnitude = 0;
+    for (const char ch : text)
+    {
+        if (ch >= '0' && ch <= '9')
+        {
+            magnitude = magnitude * 10 + (ch - '0');
+        }
+    }
+    if (magnitude > uint64_t(INT64_MAX))
+    {
+        return false;
+    }
+    value = text[0] == '-' ? -int64_t(magnitude) : int64_t(magnitude);
+    return true;
+}
+
+static std::string PrintTableFormatScaled(int64_t value, int scale)
+{
+    if (scale == 0)
+    {
+        return std::to_string(value);
+    }
+    const uint64_t magnitude = value < 0 ? uint64_t(0) - uint64_t(value) : uint64_t(value);
+    std::string fraction = std::to_string(magnitude % PRINT_TABLE_POWERS_OF_10[scale]);
+    fraction.insert(0, scale - fraction.length(), '0');
+    return (value < 0 ? "-" : "") + std::to_string(magnitude / PRINT_TABLE_POWERS_OF_10[scale]) + "." + fraction;
+}
+
+static int PrintTablePopCount(uint64_t word)
+{
+#ifdef __GNUC__
+    return __builtin_popcountll(word);
+#else
+    int count = 0;
+    for (; word != 0; word &= word - 1)
+    {
+        count++;
+    }
+    return count;
+#endif
+}
+
+static bool PrintTableIsNull(const PrintTableColumn& column, size_t row)
+{
+    return !column.validity.Empty() && !(column.validity[row / 64] >> (row % 64) & 1);
+}
+
+// Position of the cell of a resident row among the resident cells that are not null
+static size_t PrintTableValueIndex(const PrintTableColumn& column, size_t row)
+{
+    if (column.validity.Empty())
+    {
+        return row - column.sealedRows;
+    }
+    const uint64_t earlierRows = (uint64_t(1) << (row % 64)) - 1;
+    return column.validBefore[row / 64] + PrintTablePopCount(column.validity[row / 64] & earlierRows) - column.sealedValues;
+}
+
+static size_t PrintTableNumValues(const PrintTableColumn& column)
+{
+    return column.typedStorage ? column.numbers.Size() : column.cells.Size();
+}
+
+// Creates the validity bitmap of a column without nulls, with a bit set for every row
+static void PrintTableEnsureValidity(PrintTableColumn& column)
+{
+    if (!column.validity.Empty())
+    {
+        return;
+    }
+    const size_t numRows = column.sealedValues + PrintTableNumValues(column);
+    column.validity.Assign((numRows + 63) / 64, ~uint64_t(0));
+    if (numRows % 64 != 0)
+    {
+        column.validity.Mutable(column.validity.Size() - 1) = (uint64_t(1) << (numRows % 64)) - 1;
+    }
+    for (size_t w = 0; w < column.validity.Size(); w++)
+    {
+        column.validBefore.PushBack(w * 64);
+    }
+}
+
+// Adds the validity bit of a new row, before its cell is appended
+static void PrintTableAppendValidity(PrintTableColumn& column, bool valid)
+{
+    if (valid && column.validity.Empty())
+    {
+        return;
+    }
+    PrintTableEnsureValidity(column);
+    const size_t row = column.sealedValues + PrintTableNumValues(column) + column.nullCount;
+    if (row / 64 == column.validity.Size())
+    {
+        column.validity.PushBack(0);
+        column.validBefore.PushBack(column.sealedValues + PrintTableNumValues(column));
+    }
+    if (valid)
+    {
+        column.validity.Mutable(row / 64) |= uint64_t(1) << (row % 64);
+    }
+    else
+    {
+        column.nullCount++;
+    }
+}
+
+static const int64_t PRINT_TABLE_NS_PER_MINUTE = 60000000000LL;
+
+// Formats a timestamp, only formatting its date, hour and minute when they differ from the previous timestamp
+static void PrintTableFormatTimestamp(const PrintTableColumn& column, int64_t timestamp, std::string& text)
+{
+    const int64_t local = timestamp + column.utcOffset;
+    int64_t minute = local / PRINT_TABLE_NS_PER_MINUTE;
+    int64_t nanoseconds = local % PRINT_TABLE_NS_PER_MINUTE;
+    if (nanoseconds < 0)
+    {
+        minute--;
+        nanoseconds += PRINT_TABLE_NS_PER_MINUTE;
+    }
+    if (minute != column.cachedMinute)
+    {
+        // Civil date from days since 1970-01-01, see http://howardhinnant.github.io/date_algorithms.html
+        const int64_t days = (minute >= 0 ? minute : minute - 1439) / 1440;
+        const int64_t z = days + 719468;
+        const int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+        const int64_t dayOfEra = z - era * 146097;
+        const int64_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+        const int64_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+        const int64_t shiftedMonth = (5 * dayOfYear + 2) / 153;
+        const int day = int(dayOfYear - (153 * shiftedMonth + 2) / 5 + 1);
+        const int month = int(shiftedMonth < 10 ? shiftedMonth + 3 : shiftedMonth - 9);
+        const int64_t year = yearOfEra + era * 400 + (month <= 2 ? 1 : 0);
+        const int64_t minuteOfDay = minute - days * 1440;
+        char prefix[64];
+        snprintf(prefix, sizeof(prefix), "%04lld-%02d-%02d %02d:%02d:", (long long)year, month, day, int(minuteOfDay / 60), int(minuteOfDay % 60));
+        column.cachedPrefix = prefix;
+        column.cachedMinute = minute;
+    }
+    text = column.cachedPrefix;
+    const int seconds = int(nanoseconds / 1000000000);
+    text += char('0' + seconds / 10);
+    text += char('0' + seconds % 10);
+    if (column.fractionDigits > 0)
+    {
+        std::string fraction = std::to_string(nanoseconds % 1000000000 / PRINT_TABLE_POWERS_OF_10[9 - column.fractionDigits]);
+        text += '.';
+        text.append(column.fractionDigits - fraction.length(), '0');
+        text += fraction;
+    }
+}
+
+// Picks the unit of a duration, returning the number of nanoseconds per hundredth of it (0 for ns)
+static uint64_t PrintTableDurationUnit(uint64_t magnitude, const char*& unit)
+{
+    if (magnitude < 1000ULL)
+    {
+        unit = "ns";
+        return 0;
+    }
+    unit = magnitude < 999995ULL ? "us" : magnitude < 999995000ULL ? "ms" : "s";
+    return magnitude < 999995ULL ? 10ULL : magnitude < 999995000ULL ? 10000ULL : 10000000ULL;
+}
+
+// Formats a duration with 2 decimals in the largest unit that keeps it below 1000, e.g. "12.35ms"
+static void PrintTableFormatDuration(int64_t duration, std::string& text)
+{
+    const uint64_t magnitude = duration < 0 ? uint64_t(0) - uint64_t(duration) : uint64_t(duration);
+    const char* unit;
+    const uint64_t hundredth = PrintTableDurationUnit(magnitude, unit);
+    text = duration < 0 ? "-" : "";
+    if (hundredth == 0)
+    {
+        text += std::to_string(magnitude) + unit;
+        return;
+    }
+    const uint64_t hundredths = magnitude / hundredth + (magnitude % hundredth >= hundredth / 2 ? 1 : 0);
+    text += std::to_string(hundredths / 100) + "." + char('0' + hundredths / 10 % 10) + char('0' + hundredths % 10) + unit;
+}
+
+// Number of characters a stored number takes up when printed, computed without formatting it
+static int PrintTableStoredWidth(const PrintTableColumn& column, int64_t number)
+{
+    if (column.type == PrintTableColumnType::Timestamp)
+    {
+        return 19 + (column.fractionDigits > 0 ? column.fractionDigits + 1 : 0);
+    }
+    if (column.type == PrintTableColumnType::Duration)
+    {
+        const uint64_t magnitude = number < 0 ? uint64_t(0) - uint64_t(number) : uint64_t(number);
+        const char* unit;
+        const uint64_t hundredth = PrintTableDurationUnit(magnitude, unit);
+        uint64_t integer = hundredth == 0 ? magnitude : (magnitude / hundredth + (magnitude % hundredth >= hundredth / 2 ? 1 : 0)) / 100;
+        int width = (number < 0 ? 1 : 0) + int(strlen(unit)) + (hundredth == 0 ? 0 : 3);
+        do
+        {
+            width++;
+            integer /= 10;
+        } while (integer != 0);
+        return width;
+    }
+    int width = (number < 0 ? 2 : 1) + (column.scale > 0 ? column.scale + 1 : 0);
+    uint64_t integer = (number < 0 ? uint64_t(0) - uint64_t(number) : uint64_t(number)) / PRINT_TABLE_POWERS_OF_10[column.scale];
+    for (; integer >= 10; integer /= 10)
+    {
+        width++;
+    }
+    return width;
+}
+
+// Formats a number from typed storage the way a column of the given type and scale prints it
+static void PrintTableFormatStored(const PrintTableColumn& column, PrintTableColumnType type, int scale, int64_t number, std::string& text)
+{
+    if (type == PrintTableColumnType::Timestamp)
+    {
+        PrintTableFormatTimestamp(column, number, text);
+    }
+    else if (type == PrintTableColumnType::Duration)
+    {
+        PrintTableFormatDuration(number, text);
+    }
+    else
+    {
+        text = PrintTableFormatScaled(number, scale);
+    }
+}
+
+static void PrintTableAppendVarint(std::string& output, uint64_t value)
+{
+    for (; value >= 128; value >>= 7)
+    {
+        output += char((value & 127) | 128);
+    }
+    output += char(value);
+}
+
+static uint64_t PrintTableReadVarint(const unsigned char*& data)
+{
+    uint64_t value = 0;
+    for (int shift = 0;; shift += 7)
+    {
+        const unsigned char byte = *data++;
+        value |= uint64_t(byte & 127) << shift;
+        if (byte < 128)
+        {
+            return value;
+        }
+    }
+}
+
+// Cells are logged as their length + 1, or 0 if null, followed by their text
+static void PrintTableAppendLogCell(std::string& payload, const std::string* cell)
+{
+    PrintTableAppendVarint(payload, cell == nullptr ? 0 : cell->length() + 1);
+    if (cell != nullptr)
+    {
+        payload += *cell;
+    }
+}
+
+// Returns nullptr if the cell is null, otherwise cell holding its text
+static const std::string* PrintTableReadLogCell(const unsigned char*& data, std::string& cell)
+{
+    const size_t length = PrintTableReadVarint(data);
+    if (length == 0)
+    {
+        return nullptr;
+    }
+    cell.assign((const char*)data, length - 1);
+    data += length - 1;
+    return &cell;
+}
+
+static void PrintTableAppendLZLength(std::string& output, size_t length)
+{
+    for (; length >= 255; length -= 255)
+    {
+        output += char(255);
+    }
+    output += char(length);
+}
+
+// LZ77 in the style of LZ4. Each sequence is a token holding the number of literals and the match length - 4 in its
+// high and low 4 bits (15 meaning more length bytes follow), the literals, and the 2 byte offset of the match.
+// The last sequence only has literals.
+static void PrintTableCompressLZ(const std::string& input, std::string& output)
+{
+    const unsigned char* src = (const unsigned char*)input.data();
+    const size_t length = input.length();
+    std::vector<uint32_t> table(size_t(1) << 14, UINT32_MAX); // Last position of each hashed 4 byte sequence
+    size_t anchor = 0;
+    size_t i = 0;
+    while (i + 4 <= length)
+    {
+        uint32_t sequence;
+        memcpy(&sequence, src + i, sizeof(sequence));
+        const uint32_t hash = (sequence * 2654435761u) >> 18;
+        const size_t candidate = table[hash];
+        table[hash] = uint32_t(i);
+        uint32_t candidateSequence = ~sequence;
+        if (candidate != UINT32_MAX && i - candidate <= 65535)
+        {
+            memcpy(&candidateSequence, src + candidate, sizeof(candidateSequence));
+        }
+        if (candidateSequence != sequence)
+        {
+            i++;
+            continue;
+        }
+        size_t matchLength = 4;
+        while (i + matchLength < length && src[candidate + matchLength] == src[i + matchLength])
+        {
+            matchLength++;
+        }
+        const size_t numLiterals = i - anchor;
+        output += char(std::min(numLiterals, size_t(15)) << 4 | std::min(matchLength - 4, size_t(15)));
+        if (numLiterals >= 15)
+        {
+            PrintTableAppendLZLength(output, numLiterals - 15);
+        }
+        output.append(input, anchor, numLiterals);
+        output += char((i - candidate) & 255);
+        output += char((i - candidate) >> 8);
+        if (matchLength - 4 >= 15)
+        {
+            PrintTableAppendLZLength(output, matchLength - 4 - 15);
+        }
+        i += matchLength;
+        anchor = i;
+    }
+    const size_t numLiterals = length - anchor;
+    output += char(std::min(numLiterals, size_t(15)) << 4);
+    if (numLiterals >= 15)
+    {
+        PrintTableAppendLZLength(output, numLiterals - 15);
+    }
+    output.append(input, anchor, numLiterals);
+}
+
+static void PrintTableDecompressLZ(const unsigned char* data, const unsigned char* end, std::string& output)
+{
+    while (data < end)
+    {
+        const unsigned char token = *data++;
+        size_t numLiterals = token >> 4;
+        for (unsigned char more = numLiterals == 15 ? 255 : 0; more == 255; numLiterals += more)
+        {
+            more = *data++;
+        }
+        output.append((const char*)data, numLiterals);
+        data += numLiterals;
+        if (data >= end)
+        {
+            break;
+        }
+        const size_t offset = data[0] | size_t(data[1]) << 8;
+        data += 2;
+        size_t matchLength = token & 15;
+        for (unsigned char more = matchLength == 15 ? 255 : 0; more == 255; matchLength += more)
+        {
+            more = *data++;
+        }
+        // The match may overlap the bytes it produces, so it is copied byte by byte
+        const size_t start = output.length() - offset;
+        for (size_t k = 0; k < matchLength + 4; k++)
+        {
+            output += output[start + k];
+        }
+    }
+}
+
+enum class PrintTableChunkEncoding : char
+{
+    Plain,      // Text: a varint length per row, then the cells
+    Dictionary, // Text: the distinct cells as for Plain, then a 2 byte code per row
+    Delta       // Typed: the difference of each number to the previous one
+};
+
+// Compresses the layout of a sealed chunk. The layout is first encoded in a way that exposes its redundancy to LZ77:
+// text by its lengths instead of offsets, or by a dictionary if that is smaller, numbers by their deltas.
+static void PrintTableCompressChunk(const std::string& layout, bool typed, std::string& compressed)
+{
+    std::string encoded;
+    PrintTableChunkEncoding encoding = PrintTableChunkEncoding::Delta;
+    if (typed)
+    {
+        uint64_t previous = 0;
+        for (size_t i = 0; i < PRINT_TABLE_CHUNK_ROWS; i++)
+        {
+            uint64_t number;
+            memcpy(&number, layout.data() + i * sizeof(number), sizeof(number));
+            const uint64_t delta = number - previous;
+            encoded.append((const char*)&delta, sizeof(delta));
+            previous = number;
+        }
+    }
+    else
+    {
+        const char* text = layout.data() + (PRINT_TABLE_CHUNK_ROWS + 1) * sizeof(uint32_t);
+        std::vector<uint32_t> offsets(PRINT_TABLE_CHUNK_ROWS + 1);
+        memcpy(offsets.data(), layout.data(), offsets.size() * sizeof(uint32_t));
+        std::unordered_map<std::string, uint16_t> codes;
+        std::string dictionary;
+        size_t distinctBytes = 0;
+        std::string codeBytes;
+        std::string lengths;
+        for (size_t i = 0; i < PRINT_TABLE_CHUNK_ROWS; i++)
+        {
+            PrintTableAppendVarint(lengths, offsets[i + 1] - offsets[i]);
+            if (codes.size() > 65535)
+            {
+                continue;
+            }
+            const auto code = codes.insert({ std::string(text + offsets[i], offsets[i + 1] - offsets[i]), uint16_t(codes.size()) });
+            if (code.second)
+            {
+                PrintTableAppendVarint(dictionary, code.first->first.length());
+                distinctBytes += code.first->first.length();
+            }
+            codeBytes += char(code.first->second & 255);
+            codeBytes += char(code.first->second >> 8);
+        }
+        // Encoded sizes of both, before LZ77
+        std::string numDistinct;
+        PrintTableAppendVarint(numDistinct, codes.size());
+        const size_t dictionarySize = numDistinct.length() + dictionary.length() + distinctBytes + codeBytes.length();
+        const size_t plainSize = lengths.length() + offsets.back();
+        if (codes.size() <= 65535 && dictionarySize < plainSize)
+        {
+            // Store the distinct cells in the order of their codes
+            std::vector<const std::string*> distinct(codes.size());
+            for (const std::pair<const std::string, uint16_t>& code : codes)
+            {
+                distinct[code.second] = &code.first;
+            }
+            encoding = PrintTableChunkEncoding::Dictionary;
+            encoded += numDistinct;
+            encoded += dictionary;
+            for (const std::string* cell : distinct)
+            {
+                encoded += *cell;
+            }
+            encoded += codeBytes;
+        }
+        else
+        {
+            encoding = PrintTableChunkEncoding::Plain;
+            encoded += lengths;
+            encoded.append(text, offsets.back());
+        }
+    }
+    compressed.clear();
+    compressed += char(encoding);
+    PrintTableAppendVarint(compressed, encoded.length());
+    PrintTableCompressLZ(encoded, compressed);
+}
+
+static void PrintTableDecompressChunk(const std::string& compressed, std::string& layout)
+{
+    const unsigned char* data = (const unsigned char*)compressed.data();
+    const PrintTableChunkEncoding encoding = PrintTableChunkEncoding(*data++);
+    std::string encoded;
+    encoded.reserve(PrintTableReadVarint(data));
+    PrintTableDecompressLZ(data, (const unsigned char*)compressed.data() + compressed.length(), encoded);
+
+    layout.clear();
+    if (encoding == PrintTableChunkEncoding::Delta)
+    {
+        uint64_t number = 0;
+        for (size_t i = 0; i < PRINT_TABLE_CHUNK_ROWS; i++)
+        {
+            uint64_t delta;
+            memcpy(&delta, encoded.data() + i * sizeof(delta), sizeof(delta));
+            number += delta;
+            layout.append((const char*)&number, sizeof(number));
+        }
+        return;
+    }
+    std::vector<uint32_t> offsets(PRINT_TABLE_CHUNK_ROWS + 1, 0);
+    std::string text;
+    const unsigned char* position = (const unsigned char*)encoded.data();
+    if (encoding == PrintTableChunkEncoding::Plain)
+    {
+        for (size_t i = 0; i < PRINT_TABLE_CHUNK_ROWS; i++)
+        {
+            offsets[i + 1] = offsets[i] + PrintTableReadVarint(position);
+        }
+        text.assign((const char*)position, offsets.back());
+    }
+    else
+    {
+        std::vector<size_t> lengths(PrintTableReadVarint(position));
+        for (size_t& length : lengths)
+        {
+            length = PrintTableReadVarint(position);
+        }
+        std::vector<std::string> distinct(lengths.size());
+        for (size_t d = 0; d < lengths.size(); d++)
+        {
+            distinct[d].assign((const char*)position, lengths[d]);
+            position += lengths[d];
+        }
+        for (size_t i = 0; i < PRINT_TABLE_CHUNK_ROWS; i++)
+        {
+            const std::string& cell = distinct[position[0] | size_t(position[1]) << 8];
+            position += 2;
+            text += cell;
+            offsets[i + 1] = text.length();
+        }
+    }
+    layout.assign((const char*)offsets.data(), offsets.size() * sizeof(uint32_t));
+    layout += text;
+}
+
+// Returns the layout of a sealed chunk, decompressing it if it is compressed and not the one read last
+static const char* PrintTableSealedData(const PrintTableColumn& column, size_t chunkIndex)
+{
+    const PrintTableSealedChunk& chunk = column.sealedChunks[chunkIndex];
+    if (chunk.data != nullptr)
+    {
+        return chunk.data;
+    }
+    if (column.decompressedChunk != chunkIndex)
+    {
+        PrintTableDecompressChunk(*chunk.compressed, column.decompressed);
+        column.decompressedChunk = chunkIndex;
+    }
+    return column.decompressed.data();
+}
+
+// Reads the cell of a sealed row from its chunk
+static const std::string& PrintTableSealedCellText(const PrintTableColumn& column, size_t row, std::string& scratch)
+{
+    const PrintTableSealedChunk& chunk = column.sealedChunks[row / PRINT_TABLE_CHUNK_ROWS];
+    const char* data = PrintTableSealedData(column, row / PRINT_TABLE_CHUNK_ROWS);
+    const size_t i = row % PRINT_TABLE_CHUNK_ROWS;
+    if (chunk.typed)
+    {
+        int64_t number;
+        memcpy(&number, data + i * sizeof(int64_t), sizeof(number));
+        PrintTableFormatStored(column, chunk.type, chunk.scale, number, scratch);
+        return scratch;
+    }
+    uint32_t offsets[2];
+    memcpy(offsets, data + i * sizeof(uint32_t), sizeof(offsets));
+    scratch.assign(data + (PRINT_TABLE_CHUNK_ROWS + 1) * sizeof(uint32_t) + offsets[0], offsets[1] - offsets[0]);
+    return scratch;
+}
+
+// Text of the cell of a frozen column at index among the cells that are not null
+static void PrintTableFrozenText(const PrintTableFrozenCells& frozen, size_t index, const char*& text, size_t& length)
+{
+    const size_t i = frozen.codes.empty() ? index : frozen.codes[index];
+    text = frozen.blob.data() + frozen.offsets[i];
+    length = frozen.offsets[i + 1] - frozen.offsets[i];
+}
+
+// Returns the text of a cell, which is empty if it is null. Cells in typed storage are formatted into scratch,
+// which the result then refers to.
+static const std::string& PrintTableCellText(const PrintTableColumn& column, size_t row, std::string& scratch)
+{
+    if (PrintTableIsNull(column, row))
+    {
+        scratch.clear();
+        return scratch;
+    }
+    if (column.frozen)
+    {
+        const char* text;
+        size_t length;
+        PrintTableFrozenText(*column.frozen, PrintTableValueIndex(column, row), text, length);
+        scratch.assign(text, length);
+        return scratch;
+    }
+    if (row < column.sealedRows)
+    {
+        return PrintTableSealedCellText(column, row, scratch);
+    }
+    const size_t index = PrintTableValueIndex(column, row);
+    if (!column.typedStorage)
+    {
+        return column.cells[index];
+    }
+    PrintTableFormatStored(column, column.type, column.scale, column.numbers[index], scratch);
+    return scratch;
+}
+
+// Moves a column from typed storage back to storing text, for when a value cannot be stored exactly
+static void PrintTableUntypeColumn(PrintTableColumn& column)
+{
+    std::string text;
+    for (size_t r = 0; r < column.numbers.Size(); r++)
+    {
+        PrintTableFormatStored(column, column.type, column.scale, column.numbers[r], text);
+        column.cells.PushBack(text);
+    }
+    column.numbers.Clear();
+    column.typedStorage = false;
+    column.type = PrintTableColumnType::Text;
+}
+
+static void PrintTableAppendToColumn(PrintTableColumn& column, const std::string& value)
+{
+    PrintTableAppendValidity(column, true);
+    int64_t number;
+    if (column.typedStorage && PrintTableParseScaled(value, column.scale, number))
+    {
+        column.numbers.PushBack(number);
+        return;
+    }
+    if (column.typedStorage)
+    {
+        PrintTableUntypeColumn(column);
+    }
+    column.cells.PushBack(value);
+}
+
+// Replaces the cell of row with value, or with null if value is nullptr.
+// Cells changing between null and not null are inserted into or erased from the stored cells.
+static void PrintTableStoreCell(PrintTableColumn& column, size_t row, const std::string* value)
+{
+    const bool wasNull = PrintTableIsNull(column, row);
+    if (value == nullptr)
+    {
+        if (wasNull)
+        {
+            return;
+        }
+        PrintTableEnsureValidity(column);
+        const size_t index = PrintTableValueIndex(column, row);
+        if (column.typedStorage)
+        {
+            column.numbers.Erase(index);
+        }
+        else
+        {
+            column.cells.Erase(index);
+        }
+        column.validity.Mutable(row / 64) &= ~(uint64_t(1) << (row % 64));
+        for (size_t w = row / 64 + 1; w < column.validBefore.Size(); w++)
+        {
+            column.validBefore.Mutable(w)--;
+        }
+        column.nullCount++;
+        return;
+    }
+
+    int64_t number = 0;
+    const bool fits = column.typedStorage && PrintTableParseScaled(*value, column.scale, number);
+    if (column.typedStorage && !fits)
+    {
+        PrintTableUntypeColumn(column);
+    }
+    const size_t index = PrintTableValueIndex(column, row);
+    if (wasNull)
+    {
+        if (fits)
+        {
+            column.numbers.Insert(index, 0);
+        }
+        else
+        {
+            column.cells.Insert(index, std::string());
+        }
+        column.validity.Mutable(row / 64) |= uint64_t(1) << (row % 64);
+        for (size_t w = row / 64 + 1; w < column.validBefore.Size(); w++)
+        {
+            column.validBefore.Mutable(w)++;
+        }
+        column.nullCount--;
+    }
+    if (fits)
+    {
+        column.numbers.Mutable(index) = number;
+    }
+    else
+    {
+        column.cells.Mutable(index) = *value;
+    }
+}
+
+// Estimate of the memory taken up by a resident cell. Frozen cells can not be spilled, so they do not count.
+static size_t PrintTableCellBytes(const PrintTableColumn& column, size_t row)
+{
+    if (PrintTableIsNull(column, row) || column.frozen)
+    {
+        return 0;
+    }
+    if (column.typedStorage)
+    {
+        return sizeof(int64_t);
+    }
+    // Short strings are stored inside the std::string itself
+    const size_t length = column.cells[PrintTableValueIndex(column, row)].length();
+    return sizeof(std::string) + (length > 15 ? length + 1 : 0);
+}
+
+// Number of characters a resident cell takes up when printed, not counting nulls
+static int PrintTableCellWidth(const PrintTableColumn& column, size_t row)
+{
+    if (PrintTableIsNull(column, row))
+    {
+        return 0;
+    }
+    const size_t index = PrintTableValueIndex(column, row);
+    if (column.frozen)
+    {
+        const char* text;
+        size_t length;
+        PrintTableFrozenText(*column.frozen, index, text, length);
+        return int(length);
+    }
+    return column.typedStorage ? PrintTableStoredWidth(column, column.numbers[index]) : int(column.cells[index].length());
+}
+
+static uint64_t PrintTableRowFingerprint(const PrintTable& table, size_t row)
+{
+    uint64_t fingerprint = 0;
+    std::string scratch;
+    for (const PrintTableColumn& column : table.columns)
+    {
+        if (PrintTableIsNull(column, row))
+        {
+            // Distinguishes a null from an empty cell
+            fingerprint = PrintTableMix(fingerprint ^ 0x6e756c6cULL);
+            continue;
+        }
+        const std::string& cell = PrintTableCellText(column, row, scratch);
+        fingerprint = PrintTableHash(cell.data(), cell.length(), fingerprint);
+    }
+    return fingerprint;
+}
+
+// The contribution of a row to rowsFingerprint. Mixing in the row index makes the sum order dependent,
+// while keeping it a sum lets a single row be replaced by subtracting its old term.
+static uint64_t PrintTableRowsFingerprintTerm(uint64_t rowFingerprint, size_t row)
+{
+    return PrintTableMix(rowFingerprint + (row + 1) * 0x9e3779b97f4a7c15ULL);
+}
+
+// Parses a whole cell as a number if it is an optional sign, digits and optionally '.' and more digits. Anything
+// else strtod would take, such as "inf", "nan", "0x10", " 7" or "1e3", is text.
+static bool PrintTableParseNumber(const std::string& cell, double& number)
+{
+    const size_t start = !cell.empty() && (cell[0] == '-' || cell[0] == '+') ? 1 : 0;
+    const size_t point = cell.find('.', start);
+    const size_t integerDigits = (point == std::string::npos ? cell.length() : point) - start;
+    if (integerDigits == 0 || !PrintTableAllDigits(cell.data() + start, integerDigits))
+    {
+        return false;
+    }
+    if (point != std::string::npos && (point + 1 == cell.length() || !PrintTableAllDigits(cell.data() + point + 1, cell.length() - point - 1)))
+    {
+        return false;
+    }
+    char* end;
+    number = strtod(cell.c_str(), &end);
+    return end == cell.c_str() + cell.length();
+}
+
+// Reads a cell as a number, straight from typed storage if the column has it
+static bool PrintTableCellNumber(const PrintTableColumn& column, size_t row, double& number)
+{
+    if (PrintTableIsNull(column, row))
+    {
+        return false;
+    }
+    if (column.frozen)
+    {
+        std::string scratch;
+        return PrintTableParseNumber(PrintTableCellText(column, row, scratch), number);
+    }
+    if (row < column.sealedRows)
+    {
+        const PrintTableSealedChunk& chunk = column.sealedChunks[row / PRINT_TABLE_CHUNK_ROWS];
+        if (!chunk.typed)
+        {
+            std::string scratch;
+            return PrintTableParseNumber(PrintTableSealedCellText(column, row, scratch), number);
+        }
+        int64_t stored;
+        memcpy(&stored, PrintTableSealedData(column, row / PRINT_TABLE_CHUNK_ROWS) + row % PRINT_TABLE_CHUNK_ROWS * sizeof(int64_t), sizeof(stored));
+        number = double(stored) / double(PRINT_TABLE_POWERS_OF_10[chunk.scale]);
+        return true;
+    }
+    const size_t index = PrintTableValueIndex(column, row);
+    if (column.typedStorage)
+    {
+        number = double(column.numbers[index]) / double(PRINT_TABLE_POWERS_OF_10[column.scale]);
+        return true;
+    }
+    return PrintTableParseNumber(column.cells[index], number);
+}
+
+// Returns the cells of a column as text, by row. Resident text cells without nulls are read in place from their blocks,
+// which copies of the table share, anything else is copied or formatted into scratch.
+static const PrintTableCowVector<std::string>& PrintTableColumnCells(const PrintTable& table, size_t column, PrintTableCowVector<std::string>& scratch)
+{
+    const PrintTableColumn* stored = column < table.columns.size() ? &table.columns[column] : nullptr;
+    if (stored != nullptr && !stored->typedStorage && stored->nullCount == 0 && stored->sealedRows == 0)
+    {
+        return stored->cells;
+    }
+    scratch.Clear();
+    for (size_t r = 0; r < table.NumRows(); r++)
+    {
+        scratch.PushBack(table.Cell(r, column));
+    }
+    return scratch;
+}
+
+// Formats integral values without a fraction and everything else with 6 significant digits
+static std::string PrintTableFormatNumber(double number)
+{
+    char buffer[32];
+    if (number == double((long long)number) && number > -1e15 && number < 1e15)
+    {
+        snprintf(buffer, sizeof(buffer), "%lld", (long long)number);
+    }
+    else
+    {
+        snprintf(buffer, sizeof(buffer), "%.6g", number);
+    }
+    return buffer;
+}
+
+void PrintTable::SetTitle(const std::string& title)
+{
+    this->title = title;
+    alteredState = true;
+    if (publication)
+    {
+        PublishRows();
+    }
+    if (emergency)
+    {
+        UpdateEmergencyRender();
+    }
+}
+
+void PrintTable::AddColumn(const std::string& columnName)
+{
+    if (startedAddingRows)
+    {
+        printf("Table '%s' already has rows added: additional columns cannot be added.\n", title.c_str());
+        return;
+    }
+    columnNames.push_back(columnName);
+    columns.push_back(PrintTableColumn());
+    if (statsTopN > 0)
+    {
+        columnStats.push_back(PrintTableColumnStats());
+        columnStats.back().registers.assign(size_t(1) << PRINT_TABLE_HLL_PRECISION, 0);
+    }
+    alteredState = true;
+}
+
+void PrintTable::AddTimestampColumn(const std::string& columnName, int fractionDigits, int utcOffsetMinutes)
+{
+    if (fractionDigits < 0 || fractionDigits > 9)
+    {
+        printf("Timestamp column '%s' cannot have %d fraction digits, it must have 0 to 9.\n", columnName.c_str(), fractionDigits);
+        return;
+    }
+    const size_t numColumns = columns.size();
+    AddColumn(columnName);
+    if (columns.size() == numColumns)
+    {
+        return;
+    }
+    PrintTableColumn& column = columns.back();
+    column.type = PrintTableColumnType::Timestamp;
+    column.typedStorage = true;
+    column.fractionDigits = fractionDigits;
+    column.utcOffset = int64_t(utcOffsetMinutes) * PRINT_TABLE_NS_PER_MINUTE;
+}
+
+void PrintTable::AddDurationColumn(const std::string& columnName)
+{
+    const size_t numColumns = columns.size();
+    AddColumn(columnName);
+    if (columns.size() == numColumns)
+    {
+        return;
+    }
+    columns.back().type = PrintTableColumnType::Duration;
+    columns.back().typedStorage = true;
+}
+
+void PrintTable::AddColumnGroup(const std::string& groupName, size_t firstColumn, size_t numColumns, size_t level)
+{
+    if (numColumns == 0 || firstColumn + numColumns > columnNames.size())
+    {
+        printf("Column group '%s' in table '%s' spans columns [%lu, %lu) while the table only has %lu columns.\n", groupName.c_str(), title.c_str(), firstColumn, firstColumn + numColumns, columnNames.size());
+        return;
+    }
+    for (const PrintTableColumnGroup& group : columnGroups)
+    {
+        if (group.level == level && firstColumn < group.firstColumn + group.numColumns && group.firstColumn < firstColumn + numColumns)
+        {
+            printf("Column group '%s' in table '%s' overlaps column group '%s' on level %lu.\n", groupName.c_str(), title.c_str(), group.name.c_str(), level);
+            return;
+        }
+    }
+    columnGroups.push_back({ groupName, firstColumn, numColumns, level });
+    alteredState = true;
+    if (emergency)
+    {
+        UpdateEmergencyRender();
+    }
+}
+
+void PrintTable::AddRow(const std::vector<std::string>& row)
+{
+    if (frozen)
+    {
+        printf("Table '%s' is frozen: rows can no longer be added.\n", title.c_str());
+        return;
+    }
+    if (row.size() != columnNames.size())
+    {
+        printf("Trying to add row with %lu elements while table '%s' requires %lu elements per row.\n", row.size(), title.c_str(), columnNames.size());
+        return;
+    }
+    for (size_t c = 0; c < row.size(); c++)
+    {
+        if (hasNullMarker && row[c] == nullMarker)
+        {
+            PrintTableAppendValidity(columns[c], false);
+        }
+        else
+        {
+            PrintTableAppendToColumn(columns[c], row[c]);
+        }
+    }
+    AppendRowMetadata(numRows++);
+    startedAddingRows = true;
+    alteredState = true;
+    if (log)
+    {
+        LogRow(row);
+        CommitLog();
+    }
+    if (publication)
+    {
+        PublishRows();
+    }
+    if (emergency)
+    {
+        UpdateEmergencyRender();
+    }
+}
+
+void PrintTable::AddRows(const std::vector<std::vector<std::string>>& rows)
+{
+    if (frozen)
+    {
+        printf("Table '%s' is frozen: rows can no longer be added.\n", title.c_str());
+        return;
+    }
+    for (const std::vector<std::string>& row : rows)
+    {
+        if (row.size() != columnNames.size())
+        {
+            printf("Trying to add row with %lu elements while table '%s' requires %lu elements per row.\n", row.size(), title.c_str(), columnNames.size());
+            continue;
+        }
+        for (size_t c = 0; c < row.size(); c++)
+        {
+            if (hasNullMarker && row[c] == nullMarker)
+            {
+                PrintTableAppendValidity(columns[c], false);
+            }
+            else
+            {
+                PrintTableAppendToColumn(columns[c], row[c]);
+            }
+        }
+        AppendRowMetadata(numRows++);
+        if (log)
+        {
+            LogRow(row);
+        }
+    }
+    if (!typesInferred)
+    {
+        InferColumnTypes();
+    }
+    startedAddingRows = true;
+    alteredState = true;
+    if (log)
+    {
+        CommitLog();
+    }
+    if (publication)
+    {
+        PublishRows();
+    }
+    if (emergency)
+    {
+        UpdateEmergencyRender();
+    }
+}
+
+// Moves the cells of a column to typed storage with scale. If a cell does not fit, the column keeps its text.
+static bool PrintTableStoreTyped(PrintTableColumn& column, int scale)
+{
+    PrintTableCowVector<int64_t> numbers;
+    for (size_t i = 0; i < column.cells.Size(); i++)
+    {
+        int64_t number;
+        if (!PrintTableParseScaled(column.cells[i], scale, number))
+        {
+            return false;
+        }
+        numbers.PushBack(number);
+    }
+    column.numbers = std::move(numbers);
+    column.scale = scale;
+    column.typedStorage = true;
+    column.cells.Clear();
+    return true;
+}
+
+// Checks for YYYY-MM-DD, optionally followed by 'T' or ' ' and a time of day starting with HH:MM
+static bool PrintTableIsTimestamp(const std::string& text)
+{
+    const char* pattern = "dddd-dd-dd";
+    if (text.length() < 10)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < 10; i++)
+    {
+        if (pattern[i] == 'd' ? !isdigit((unsigned char)text[i]) : text[i] != pattern[i])
+        {
+            return false;
+        }
+    }
+    if (text.length() == 10)
+    {
+        return true;
+    }
+    return text.length() >= 16 && (text[10] == 'T' || text[10] == ' ') && isdigit((unsigned char)text[11]) && isdigit((unsigned char)text[12]) && text[13] == ':' && isdigit((unsigned char)text[14]) && isdigit((unsigned char)text[15]);
+}
+
+static void PrintTableIndexInsert(PrintTableColumnIndex& index, const std::string& value, size_t row)
+{
+    int64_t number;
+    if (index.kind == PrintTableIndexKind::Hash)
+    {
+        index.hash[value].push_back(row);
+    }
+    else if (index.numeric && PrintTableParseScaled(value, index.scale, number))
+    {
+        index.sortedNumbers.insert({ number, row });
+    }
+    else
+    {
+        // Cells of a numeric index that are not numbers at its scale keep their text order
+        index.sorted.insert({ value, row });
+    }
+}
+
+static void PrintTableIndexErase(PrintTableColumnIndex& index, const std::string& value, size_t row)
+{
+    int64_t number;
+    if (index.kind == PrintTableIndexKind::Hash)
+    {
+        std::vector<size_t>& indexRows = index.hash[value];
+        indexRows.erase(std::find(indexRows.begin(), indexRows.end(), row));
+        if (indexRows.empty())
+        {
+            index.hash.erase(value);
+        }
+    }
+    else if (index.numeric && PrintTableParseScaled(value, index.scale, number))
+    {
+        const auto range = index.sortedNumbers.equal_range(number);
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            if (it->second == row)
+            {
+                index.sortedNumbers.erase(it);
+                break;
+            }
+        }
+    }
+    else
+    {
+        const auto range = index.sorted.equal_range(value);
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            if (it->second == row)
+            {
+                index.sorted.erase(it);
+                break;
+            }
+        }
+    }
+}
+
+// Whether a sorted index no longer orders its column the way its storage calls for, e.g. after the column was typed
+// by InferColumnTypes or went back to text for a cell that is not a number. Frozen columns can no longer change.
+static bool PrintTableIndexStale(const PrintTable& table, const PrintTableColumnIndex& index)
+{
+    const PrintTableColumn& column = table.columns[index.column];
+    const bool numeric = column.typedStorage;
+    return index.kind == PrintTableIndexKind::Sorted && !table.frozen && (index.numeric != numeric || (numeric && index.scale != column.scale));
+}
+
+// Fills an index with the cells of its column that are not null
+static void PrintTableBuildIndex(const PrintTable& table, PrintTableColumnIndex& index)
+{
+    const PrintTableColumn& column = table.columns[index.column];
+    index.hash.clear();
+    index.sorted.clear();
+    index.sortedNumbers.clear();
+    index.numeric = index.kind == PrintTableIndexKind::Sorted && column.typedStorage;
+    index.scale = column.scale;
+    if (index.kind == PrintTableIndexKind::Hash)
+    {
+        index.hash.reserve(table.numRows);
+    }
+    std::string scratch;
+    for (size_t r = 0; r < table.numRows; r++)
+    {
+        if (!PrintTableIsNull(column, r))
+        {
+            PrintTableIndexInsert(index, PrintTableCellText(column, r, scratch), r);
+        }
+    }
+}
+
+// Rebuilds the sorted indexes whose column changed type
+static void PrintTableRefreshIndexes(PrintTable& table)
+{
+    for (PrintTableColumnIndex& index : table.columnIndexes)
+    {
+        if (PrintTableIndexStale(table, index))
+        {
+            PrintTableBuildIndex(table, index);
+        }
+    }
+}
+
+// Parses the bound of a range on a numeric index, rounded inwards to the scale of the index if it has more digits
+static bool PrintTableIndexBound(const std::string& text, int scale, bool upper, int64_t& bound)
+{
+    if (PrintTableParseScaled(text, scale, bound))
+    {
+        return true;
+    }
+    double number;
+    if (!PrintTableParseNumber(text, number))
+    {
+        return false;
+    }
+    const double scaled = number * double(PRINT_TABLE_POWERS_OF_10[scale]);
+    const double rounded = upper ? floor(scaled) : ceil(scaled);
+    // 2^63 is the first double beyond the range of int64_t
+    bound = rounded >= 9223372036854775808.0 ? INT64_MAX : rounded <= -9223372036854775808.0 ? INT64_MIN : int64_t(rounded);
+    return true;
+}
+
+void PrintTable::InferColumnTypes()
+{
+    typesInferred = true;
+    for (PrintTableColumn& column : columns)
+    {
+        // Nulls are not stored in cells, so they do not affect the type
+        const size_t sampleSize = std::min(column.cells.Size(), PRINT_TABLE_INFERENCE_SAMPLE);
+        if (column.typedStorage || sampleSize == 0)
+        {
+            continue;
+        }
+        bool allNumbers = true;
+        bool allTimestamps = true;
+        int scale = PrintTableCanonicalScale(column.cells[0]);
+        std::unordered_map<std::string, size_t> distinct;
+        for (size_t r = 0; r < sampleSize; r++)
+        {
+            const std::string& cell = column.cells[r];
+            double number;
+            allNumbers = allNumbers && PrintTableParseNumber(cell, number);
+            allTimestamps = allTimestamps && PrintTableIsTimestamp(cell);
+            if (scale >= 0 && PrintTableCanonicalScale(cell) != scale)
+            {
+                scale = -1;
+            }
+            if (distinct.size() <= 16)
+            {
+                distinct[cell]++;
+            }
+        }
+
+        if (allNumbers)
+        {
+            column.type = scale == 0 ? PrintTableColumnType::Integer : PrintTableColumnType::Decimal;
+        }
+        else if (allTimestamps)
+        {
+            column.type = PrintTableColumnType::Timestamp;
+        }
+        else if (distinct.size() <= 16 && distinct.size() * 4 <= sampleSize)
+        {
+            column.type = PrintTableColumnType::Enum;
+        }
+        else
+        {
+            column.type = PrintTableColumnType::Text;
+        }
+
+        // Numbers that all share a scale and can be written back exactly are stored as 8 byte integers
+        if (allNumbers && scale >= 0)
+        {
+            PrintTableStoreTyped(column, scale);
+        }
+    }
+    // Typed cells take up less memory
+    RecountResidentBytes();
+    PrintTableRefreshIndexes(*this);
+}
+
+void PrintTable::RecountResidentBytes()
+{
+    residentBytes = 0;
+    for (size_t i = sealedRows / PRINT_TABLE_CHUNK_ROWS; i < chunks.size(); i++)
+    {
+        for (size_t c = 0; c < columns.size(); c++)
+        {
+            chunks[i].bytes[c] = 0;
+            for (size_t r = i * PRINT_TABLE_CHUNK_ROWS; r < std::min(numRows, (i + 1) * PRINT_TABLE_CHUNK_ROWS); r++)
+            {
+                chunks[i].bytes[c] += PrintTableCellBytes(columns[c], r);
+            }
+            residentBytes += chunks[i].bytes[c];
+        }
+    }
+    alteredState = true;
+}
+
+bool PrintTable::IsNumericColumn(size_t column) const
+{
+    if (column >= columns.size())
+    {
+        return computedColumns[column - columns.size()].visual == PrintTableVisual::None;
+    }
+    return columns[column].type == PrintTableColumnType::Integer || columns[column].type == PrintTableColumnType::Decimal || columns[column].type == PrintTableColumnType::Duration;
+}
+
+static void PrintTableIndexTrigrams(PrintTableTrigramIndex& index, const PrintTable& table, size_t r)
+{
+    std::string scratch;
+    for (const size_t c : index.columns)
+    {
+        const std::string& cell = PrintTableCellText(table.columns[c], r, scratch);
+        for (size_t i = 0; i + 3 <= cell.length(); i++)
+        {
+            const uint32_t trigram = uint32_t((unsigned char)cell[i]) << 16 | uint32_t((unsigned char)cell[i + 1]) << 8 | uint32_t((unsigned char)cell[i + 2]);
+            std::vector<uint32_t>& posting = index.postings[trigram];
+            // Rows are indexed in order, so a duplicate can only be the last entry
+            if (posting.empty() || posting.back() != r)
+            {
+                posting.push_back(r);
+            }
+        }
+    }
+}
+
+// Orders two order keys numerically if both are numbers, and as strings otherwise
+static int PrintTableCompareKeys(const std::string& a, const std::string& b)
+{
+    double numberA;
+    double numberB;
+    if (PrintTableParseNumber(a, numberA) && PrintTableParseNumber(b, numberB))
+    {
+        return numberA < numberB ? -1 : numberA > numberB ? 1 : 0;
+    }
+    return a.compare(b);
+}
+
+// Extends a running sum or delta with a newly added row if the row comes last in its partition
+static void PrintTableAppendComputedValue(const PrintTable& table, const PrintTableComputedColumn& computed, size_t row)
+{
+    if (computed.dirty)
+    {
+        return;
+    }
+    if (computed.visual != PrintTableVisual::None)
+    {
+        double value = 0.0;
+        const bool isNumber = PrintTableCellNumber(table.columns[computed.valueColumn], row, value);
+        computed.values.push_back(value);
+        computed.valid.push_back(isNumber);
+        if (isNumber)
+        {
+            computed.minValue = std::min(computed.minValue, value);
+            computed.maxValue = std::max(computed.maxValue, value);
+        }
+        return;
+    }
+    if (computed.function == PrintTableWindow::Rank)
+    {
+        computed.dirty = true;
+        return;
+    }
+    const std::string partitionKey = computed.partitionColumn < 0 ? std::string() : table.Cell(row, computed.partitionColumn);
+    const std::string orderKey = computed.orderColumn < 0 ? std::string() : table.Cell(row, computed.orderColumn);
+    double value = 0.0;
+    const bool isNumber = PrintTableCellNumber(table.columns[computed.valueColumn], row, value);
+    const auto it = computed.partitions.find(partitionKey);
+    if (it != computed.partitions.end() && computed.orderColumn >= 0 && PrintTableCompareKeys(orderKey, it->second.lastOrderKey) < 0)
+    {
+        // Appended out of order, so every later row of the partition would have to change
+        computed.dirty = true;
+        return;
+    }
+    PrintTableComputedColumn::PartitionState& state = computed.partitions[partitionKey];
+    if (computed.function == PrintTableWindow::RunningSum)
+    {
+        state.sum += value;
+        computed.values.push_back(state.sum);
+        computed.valid.push_back(true);
+    }
+    else
+    {
+        computed.values.push_back(value - state.last);
+        computed.valid.push_back(isNumber && state.hasLast);
+        if (isNumber)
+        {
+            state.last = value;
+            state.hasLast = true;
+        }
+    }
+    state.lastOrderKey = orderKey;
+    if (computed.valid.back())
+    {
+        computed.maxCellWidth = std::max(computed.maxCellWidth, int(PrintTableFormatNumber(computed.values.back()).length()));
+    }
+}
+
+void PrintTable::AddWindowColumn(const std::string& name, PrintTableWindow function, const std::string& valueColumn, const std::string& orderColumn, const std::string& partitionColumn)
+{
+    PrintTableComputedColumn computed;
+    computed.name = name;
+    computed.function = function;
+    const int valueIndex = FindColumn(valueColumn);
+    computed.orderColumn = orderColumn.empty() ? -1 : FindColumn(orderColumn);
+    computed.partitionColumn = partitionColumn.empty() ? -1 : FindColumn(partitionColumn);
+    if (valueIndex < 0 || (!orderColumn.empty() && computed.orderColumn < 0) || (!partitionColumn.empty() && computed.partitionColumn < 0))
+    {
+        printf("Columns '%s', '%s' and '%s' used by window column '%s' must exist in table '%s'.\n", valueColumn.c_str(), orderColumn.c_str(), partitionColumn.c_str(), name.c_str(), title.c_str());
+        return;
+    }
+    computed.valueColumn = valueIndex;
+    computedColumns.push_back(computed);
+    alteredState = true;
+    if (emergency)
+    {
+        UpdateEmergencyRender();
+    }
+}
+
+void PrintTable::AddVisualColumn(const std::string& name, PrintTableVisual visual, const std::string& valueColumn, int width)
+{
+    const int valueIndex = FindColumn(valueColumn);
+    if (valueIndex < 0 || visual == PrintTableVisual::None || width < 1)
+    {
+        printf("Visual column '%s' in table '%s' needs an existing value column and a width of at least 1.\n", name.c_str(), title.c_str());
+        return;
+    }
+    PrintTableComputedColumn computed;
+    computed.name = name;
+    computed.function = PrintTableWindow::RunningSum;
+    computed.valueColumn = valueIndex;
+    computed.orderColumn = -1;
+    computed.partitionColumn = -1;
+    computed.visual = visual;
+    computed.width = width;
+    if (visual == PrintTableVisual::Bar)
+    {
+        // U+2588 (full block) to U+258F (one eighth block), all of them 3 bytes in UTF-8
+        const std::string eighths[8] = { "", "\xe2\x96\x8f", "\xe2\x96\x8e", "\xe2\x96\x8d", "\xe2\x96\x8c", "\xe2\x96\x8b", "\xe2\x96\x8a", "\xe2\x96\x89" };
+        const std::string full = "\xe2\x96\x88";
+        for (int level = 0; level <= width * 8; level++)
+        {
+            std::string bar;
+            for (int i = 0; i < level / 8; i++)
+            {
+                bar += full;
+            }
+            bar += eighths[level % 8];
+            bar.append(width - level / 8 - (level % 8 != 0 ? 1 : 0), ' ');
+            computed.glyphs.push_back(bar);
+        }
+    }
+    else
+    {
+        // U+2581 (lower one eighth block) to U+2588 (full block)
+        for (int level = 0; level < 8; level++)
+        {
+            computed.glyphs.push_back(std::string("\xe2\x96") + char(0x81 + level));
+        }
+    }
+    computedColumns.push_back(computed);
+    alteredState = true;
+    if (emergency)
+    {
+        UpdateEmergencyRender();
+    }
+}
+
+void PrintTable::EvaluateComputedColumns() const
+{
+    for (const PrintTableComputedColumn& computed : computedColumns)
+    {
+        if (!computed.dirty)
+        {
+            continue;
+        }
+        computed.evaluations++;
+        computed.values.assign(numRows, 0.0);
+        computed.valid.assign(numRows, false);
+        computed.partitions.clear();
+
+        if (computed.visual != PrintTableVisual::None)
+        {
+            computed.minValue = HUGE_VAL;
+            computed.maxValue = -HUGE_VAL;
+            for (size_t r = 0; r < numRows; r++)
+            {
+                if (PrintTableCellNumber(columns[computed.valueColumn], r, computed.values[r]))
+                {
+                    computed.valid[r] = true;
+                    computed.minValue = std::min(computed.minValue, computed.values[r]);
+                    computed.maxValue = std::max(computed.maxValue, computed.values[r]);
+                }
+            }
+            computed.dirty = false;
+            continue;
+        }
+
+        // One sorted pass: rows are ordered by partition and then by order key (by value, highest first, for ranks)
+        std::vector<double> numbers(numRows, 0.0);
+        std::vector<bool> isNumber(numRows, false);
+        for (size_t r = 0; r < numRows; r++)
+        {
+            isNumber[r] = PrintTableCellNumber(columns[computed.valueColumn], r, numbers[r]);
+        }
+        std::vector<size_t> order(numRows);
+        for (size_t r = 0; r < numRows; r++)
+        {
+            order[r] = r;
+        }
+        PrintTableCowVector<std::string> partitionScratch;
+        PrintTableCowVector<std::string> orderScratch;
+        const PrintTableCowVector<std::string>* partitionCells = computed.partitionColumn < 0 ? nullptr : &PrintTableColumnCells(*this, computed.partitionColumn, partitionScratch);
+        const PrintTableCowVector<std::string>* orderCells = computed.orderColumn < 0 ? nullptr : &PrintTableColumnCells(*this, computed.orderColumn, orderScratch);
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b)
+        {
+            if (partitionCells != nullptr && (*partitionCells)[a] != (*partitionCells)[b])
+            {
+                return (*partitionCells)[a] < (*partitionCells)[b];
+            }
+            if (computed.function == PrintTableWindow::Rank)
+            {
+                // Non-numbers are ranked last
+                if (isNumber[a] != isNumber[b])
+                {
+                    return bool(isNumber[a]);
+                }
+                return numbers[a] > numbers[b];
+            }
+            return orderCells != nullptr && PrintTableCompareKeys((*orderCells)[a], (*orderCells)[b]) < 0;
+        });
+
+        for (size_t i = 0; i < numRows; i++)
+        {
+            const size_t r = order[i];
+            const bool first = i == 0 || (partitionCells != nullptr && (*partitionCells)[order[i - 1]] != (*partitionCells)[r]);
+            // The state of the partition is left as it is after its last row, so appends can continue from there
+            PrintTableComputedColumn::PartitionState& state = computed.partitions[partitionCells == nullptr ? std::string() : (*partitionCells)[r]];
+            state.lastOrderKey = orderCells == nullptr ? std::string() : (*orderCells)[r];
+            if (computed.function == PrintTableWindow::Rank)
+            {
+                // Equal values share a rank and the next distinct value skips the shared positions
+                const size_t previous = order[first ? i : i - 1];
+                const bool tied = !first && isNumber[r] && isNumber[previous] && numbers[previous] == numbers[r];
+                state.sum = first ? 1.0 : state.sum + 1.0;
+                computed.values[r] = tied ? computed.values[previous] : state.sum;
+                computed.valid[r] = isNumber[r];
+            }
+            else if (computed.function == PrintTableWindow::RunningSum)
+            {
+                state.sum += isNumber[r] ? numbers[r] : 0.0;
+                computed.values[r] = state.sum;
+                computed.valid[r] = true;
+            }
+            else
+            {
+                computed.values[r] = numbers[r] - state.last;
+                computed.valid[r] = isNumber[r] && state.hasLast;
+                if (isNumber[r])
+                {
+                    state.last = numbers[r];
+                    state.hasLast = true;
+                }
+            }
+        }
+        computed.maxCellWidth = 0;
+        for (size_t r = 0; r < numRows; r++)
+        {
+            if (computed.valid[r])
+            {
+                computed.maxCellWidth = std::max(computed.maxCellWidth, int(PrintTableFormatNumber(computed.values[r]).length()));
+            }
+        }
+        computed.dirty = false;
+    }
+}
+
+// Number of zero bits above the highest set bit, 64 if word is zero
+static int PrintTableLeadingZeros(uint64_t word)
+{
+    if (word == 0)
+    {
+        return 64;
+    }
+#ifdef __GNUC__
+    return __builtin_clzll(word);
+#else
+    int count = 0;
+    for (; !(word >> 63); word <<= 1)
+    {
+        count++;
+    }
+    return count;
+#endif
+}
+
+static void PrintTableAddToStats(PrintTableColumnStats& stats, const std::string& value, size_t topN)
+{
+    // HyperLogLog: the top bits of the hash pick a register, which keeps the longest run of leading zeros
+    // seen in the remaining bits. The bit set below them caps the run, also for a hash of zero.
+    const uint64_t hash = PrintTableHash(value.data(), value.length(), 0x5bd1e995);
+    const size_t registerIndex = hash >> (64 - PRINT_TABLE_HLL_PRECISION);
+    const uint64_t remaining = hash << PRINT_TABLE_HLL_PRECISION | uint64_t(1) << (PRINT_TABLE_HLL_PRECISION - 1);
+    const uint8_t rank = uint8_t(PrintTableLeadingZeros(remaining) + 1);
+    stats.registers[registerIndex] = std::max(stats.registers[registerIndex], rank);
+
+    // Space-Saving: a value without a counter takes over the smallest one once all counters are in use.
+    // Keeping more counters than reported makes the reported ones more accurate.
+    const auto it = stats.counterIndices.find(value);
+    if (it != stats.counterIndices.end())
+    {
+        stats.counters[it->second].count++;
+        return;
+    }
+    const size_t maxCounters = topN * 4;
+    if (stats.counters.size() < maxCounters)
+    {
+        stats.counterIndices[value] = stats.counters.size();
+        stats.counters.push_back({ value, 1, 0 });
+        return;
+    }
+    size_t smallest = 0;
+    for (size_t i = 1; i < stats.counters.size(); i++)
+    {
+        if (stats.counters[i].count < stats.counters[smallest].count)
+        {
+            smallest = i;
+        }
+    }
+    PrintTableColumnStats::Counter& counter = stats.counters[smallest];
+    stats.counterIndices.erase(counter.value);
+    stats.counterIndices[value] = smallest;
+    counter.error = counter.count;
+    counter.count++;
+    counter.value = value;
+}
+
+static double PrintTableEstimateDistinct(const PrintTableColumnStats& stats)
+{
+    const double m = double(stats.registers.size());
+    double sum = 0.0;
+    size_t zeros = 0;
+    for (const uint8_t reg : stats.registers)
+    {
+        sum += ldexp(1.0, -int(reg));
+        zeros += reg == 0 ? 1 : 0;
+    }
+    const double estimate = 0.7213 / (1.0 + 1.079 / m) * m * m / sum;
+    // Linear counting is more accurate while many registers are still empty
+    if (estimate <= 2.5 * m && zeros > 0)
+    {
+        return m * log(m / double(zeros));
+    }
+    return estimate;
+}
+
+void PrintTable::EnableColumnStats(size_t topN)
+{
+    statsTopN = std::max(topN, size_t(1));
+    columnStats = std::vector<PrintTableColumnStats>(columns.size());
+    for (size_t c = 0; c < columns.size(); c++)
+    {
+        columnStats[c].registers.assign(size_t(1) << PRINT_TABLE_HLL_PRECISION, 0);
+        std::string scratch;
+        for (size_t r = 0; r < numRows; r++)
+        {
+            if (!PrintTableIsNull(columns[c], r))
+            {
+                PrintTableAddToStats(columnStats[c], PrintTableCellText(columns[c], r, scratch), statsTopN);
+            }
+        }
+    }
+}
+
+PrintTable PrintTable::Summary() const
+{
+    PrintTable summary;
+    summary.SetTitle(title + " summary");
+    summary.AddColumn("Column");
+    summary.AddColumn("Distinct (approx.)");
+    summary.AddColumn("Most frequent (count)");
+    if (columnStats.size() != columns.size())
+    {
+        printf("Table '%s' has no column statistics: call EnableColumnStats first.\n", title.c_str());
+        return summary;
+    }
+    for (size_t c = 0; c < columns.size(); c++)
+    {
+        std::vector<PrintTableColumnStats::Counter> counters = columnStats[c].counters;
+        std::sort(counters.begin(), counters.end(), [](const PrintTableColumnStats::Counter& a, const PrintTableColumnStats::Counter& b) { return a.count > b.count; });
+        std::string frequent;
+        for (size_t i = 0; i < counters.size() && i < statsTopN; i++)
+        {
+            frequent += (i > 0 ? ", " : "") + counters[i].value + " (" + std::to_string(counters[i].count) + ")";
+        }
+        const uint64_t distinct = uint64_t(PrintTableEstimateDistinct(columnStats[c]) + 0.5);
+        summary.AddRow({ columnNames[c], std::to_string(std::min(distinct, uint64_t(numRows))), frequent });
+    }
+    return summary;
+}
+
+void PrintTable::AppendRowMetadata(size_t row)
+{
+    std::string scratch;
+    if (row % PRINT_TABLE_CHUNK_ROWS == 0)
+    {
+        chunks.push_back(PrintTableChunk());
+        chunks.back().maxCellWidths.assign(columns.size(), 0);
+        chunks.back().bytes.assign(columns.size(), 0);
+    }
+    PrintTableChunk& chunk = chunks[row / PRINT_TABLE_CHUNK_ROWS];
+    for (size_t c = 0; c < columns.size(); c++)
+    {
+        // Replayed and merged rows get their widths from the log or the parts instead
+        if (!restoringWidths)
+        {
+            const int width = PrintTableCellWidth(columns[c], row);
+            chunk.maxCellWidths[c] = std::max(chunk.maxCellWidths[c], width);
+            columns[c].maxCellWidth = std::max(columns[c].maxCellWidth, width);
+        }
+        const size_t bytes = PrintTableCellBytes(columns[c], row);
+        chunk.bytes[c] += bytes;
+        residentBytes += bytes;
+    }
+    rowFingerprints.PushBack(PrintTableRowFingerprint(*this, row));
+    rowsFingerprint += PrintTableRowsFingerprintTerm(rowFingerprints.Back(), row);
+    chunk.fingerprint += PrintTableRowsFingerprintTerm(rowFingerprints.Back(), row);
+    if (trigramIndex.built)
+    {
+        PrintTableIndexTrigrams(trigramIndex, *this, row);
+    }
+    // Nulls are left out of the indexes and statistics
+    for (PrintTableColumnIndex& index : columnIndexes)
+    {
+        if (PrintTableIndexStale(*this, index))
+        {
+            PrintTableBuildIndex(*this, index);
+        }
+        else if (!PrintTableIsNull(columns[index.column], row))
+        {
+            PrintTableIndexInsert(index, PrintTableCellText(columns[index.column], row, scratch), row);
+        }
+    }
+    for (PrintTableComputedColumn& computed : computedColumns)
+    {
+        PrintTableAppendComputedValue(*this, computed, row);
+    }
+    for (size_t c = 0; c < columnStats.size(); c++)
+    {
+        if (!PrintTableIsNull(columns[c], row))
+        {
+            PrintTableAddToStats(columnStats[c], PrintTableCellText(columns[c], row, scratch), statsTopN);
+        }
+    }
+    if (compressColdRows && numRows - sealedRows >= hotRows + PRINT_TABLE_CHUNK_ROWS)
+    {
+        CompressRows();
+    }
+    if (memoryBudget > 0 && residentBytes > memoryBudget)
+    {
+        SpillRows();
+    }
+}
+
+// Builds the layout of the oldest resident chunk of a column, see PrintTableSealedChunk.
+// Returns the number of cells in it that are not null.
+static size_t PrintTableBuildSealedLayout(const PrintTableColumn& column, PrintTableSealedChunk& chunk, std::string& layout)
+{
+    const size_t firstRow = column.sealedRows;
+    chunk.typed = column.typedStorage;
+    chunk.type = column.type;
+    chunk.scale = column.scale;
+    size_t numValues = 0;
+    if (chunk.typed)
+    {
+        layout.assign(PRINT_TABLE_CHUNK_ROWS * sizeof(int64_t), '\0');
+        for (size_t i = 0; i < PRINT_TABLE_CHUNK_ROWS; i++)
+        {
+            if (PrintTableIsNull(column, firstRow + i))
+            {
+                continue;
+            }
+            const int64_t number = column.numbers[PrintTableValueIndex(column, firstRow + i)];
+            memcpy(&layout[i * sizeof(int64_t)], &number, sizeof(number));
+            numValues++;
+        }
+        return numValues;
+    }
+    std::vector<uint32_t> offsets(PRINT_TABLE_CHUNK_ROWS + 1, 0);
+    std::string text;
+    for (size_t i = 0; i < PRINT_TABLE_CHUNK_ROWS; i++)
+    {
+        if (!PrintTableIsNull(column, firstRow + i))
+        {
+            text += column.cells[PrintTableValueIndex(column, firstRow + i)];
+            numValues++;
+        }
+        offsets[i + 1] = text.length();
+    }
+    layout.assign((const char*)offsets.data(), offsets.size() * sizeof(uint32_t));
+    layout += text;
+    return numValues;
+}
+
+// Moves the oldest resident chunk of a column out of its cells or numbers, now that chunk holds it
+static void PrintTableSealChunk(PrintTableColumn& column, const PrintTableSealedChunk& chunk, size_t numValues)
+{
+    if (column.typedStorage)
+    {
+        column.numbers.EraseFront(numValues);
+    }
+    else
+    {
+        column.cells.EraseFront(numValues);
+    }
+    column.sealedChunks.push_back(chunk);
+    column.sealedRows += PRINT_TABLE_CHUNK_ROWS;
+    column.sealedValues += numValues;
+}
+
+#ifdef PRINT_TABLE_POSIX
+PrintTableSpillMapping::~PrintTableSpillMapping()
+{
+    if (base != nullptr)
+    {
+        munmap(base, length);
+    }
+}
+
+// Writes the oldest resident chunk of every column to the end of file and maps them back in with a single mapping,
+// as the number of mappings a process may have is limited (vm.max_map_count on Linux)
+static bool PrintTableSpillChunk(std::vector<PrintTableColumn>& columns, FILE* file)
+{
+    std::vector<PrintTableSealedChunk> chunks(columns.size());
+    std::vector<size_t> numValues(columns.size());
+    std::vector<size_t> layoutOffsets(columns.size());
+    std::string buffer;
+    std::string layout;
+    for (size_t c = 0; c < columns.size(); c++)
+    {
+        numValues[c] = PrintTableBuildSealedLayout(columns[c], chunks[c], layout);
+        layoutOffsets[c] = buffer.length();
+        buffer += layout;
+    }
+
+    const int fd = fileno(file);
+    const off_t offset = lseek(fd, 0, SEEK_END);
+    if (offset < 0)
+    {
+        return false;
+    }
+    for (size_t written = 0; written < buffer.length();)
+    {
+        const ssize_t result = pwrite(fd, buffer.data() + written, buffer.length() - written, offset + written);
+        if (result <= 0)
+        {
+            return false;
+        }
+        written += result;
+    }
+    // mmap needs an offset that is a multiple of the page size
+    const off_t mappingOffset = offset - offset % sysconf(_SC_PAGESIZE);
+    const size_t mappingLength = buffer.length() + (offset - mappingOffset);
+    void* base = mmap(nullptr, mappingLength, PROT_READ, MAP_SHARED, fd, mappingOffset);
+    if (base == MAP_FAILED)
+    {
+        return false;
+    }
+    std::shared_ptr<PrintTableSpillMapping> mapping = std::make_shared<PrintTableSpillMapping>();
+    mapping->base = base;
+    mapping->length = mappingLength;
+    for (size_t c = 0; c < columns.size(); c++)
+    {
+        chunks[c].mapping = mapping;
+        chunks[c].data = (const char*)base + (offset - mappingOffset) + layoutOffsets[c];
+        PrintTableSealChunk(columns[c], chunks[c], numValues[c]);
+    }
+    return true;
+}
+#else
+PrintTableSpillMapping::~PrintTableSpillMapping()
+{
+}
+
+static bool PrintTableSpillChunk(std::vector<PrintTableColumn>&, FILE*)
+{
+    return false;
+}
+#endif
+
+#ifdef PRINT_TABLE_POSIX
+// The mapping shares the page cache with the file, so this also writes the records stored through it
+static bool PrintTableSyncFile(int fd)
+{
+#ifdef __APPLE__
+    return fsync(fd) == 0;
+#else
+    return fdatasync(fd) == 0;
+#endif
+}
+
+// Maps the first capacity bytes of the log, growing the file if it is shorter
+static bool PrintTableMapLog(PrintTableLog& log, size_t capacity)
+{
+    if (log.base != nullptr)
+    {
+        munmap(log.base, log.capacity);
+        log.base = nullptr;
+        log.capacity = 0;
+    }
+    if (capacity == 0)
+    {
+        return true;
+    }
+    struct stat status;
+    if (fstat(log.fd, &status) != 0 || (size_t(status.st_size) < capacity && ftruncate(log.fd, capacity) != 0))
+    {
+        return false;
+    }
+    void* base = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, log.fd, 0);
+    if (base == MAP_FAILED)
+    {
+        return false;
+    }
+    log.base = (char*)base;
+    log.capacity = capacity;
+    return true;
+}
+
+PrintTableLog::~PrintTableLog()
+{
+    if (base != nullptr)
+    {
+        munmap(base, capacity);
+    }
+    if (fd >= 0)
+    {
+        // Drop the zeroes the file was grown by, so the next process appends right after the last record
+        if (ftruncate(fd, length) == 0)
+        {
+            PrintTableSyncFile(fd);
+        }
+        close(fd);
+    }
+}
+#else
+static bool PrintTableSyncFile(int)
+{
+    return false;
+}
+
+static bool PrintTableMapLog(PrintTableLog&, size_t)
+{
+    return false;
+}
+
+PrintTableLog::~PrintTableLog()
+{
+}
+#endif
+
+bool PrintTable::OpenLog(const std::string& path, size_t syncRecords)
+{
+    if (numRows > 0)
+    {
+        printf("Table '%s' already has rows added: its log must be opened before the first row.\n", title.c_str());
+        return false;
+    }
+#ifdef PRINT_TABLE_POSIX
+    std::shared_ptr<PrintTableLog> opened = std::make_shared<PrintTableLog>();
+    opened->fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    opened->syncRecords = std::max(syncRecords, size_t(1));
+    struct stat status;
+    if (opened->fd < 0 || fstat(opened->fd, &status) != 0 || !PrintTableMapLog(*opened, status.st_size))
+    {
+        printf("Could not open log '%s' of table '%s'.\n", path.c_str(), title.c_str());
+        return false;
+    }
+
+    // Records are replayed up to the first one that is torn or corrupt, which is where appending resumes.
+    // A log that was created but never synced may be all zeroes.
+    const unsigned char* data = (const unsigned char*)opened->base;
+    size_t offset = 0;
+    while (offset + PRINT_TABLE_LOG_HEADER <= opened->capacity)
+    {
+        uint32_t length;
+        uint32_t checksum;
+        memcpy(&length, data + offset, sizeof(length));
+        memcpy(&checksum, data + offset + 4, sizeof(checksum));
+        const PrintTableLogRecord kind = PrintTableLogRecord(data[offset + 8]);
+        if (length > opened->capacity - offset - PRINT_TABLE_LOG_HEADER || uint32_t(PrintTableHash((const char*)data + offset + 8, length + 1, 0)) != checksum)
+        {
+            break;
+        }
+        if (offset == 0)
+        {
+            if (kind != PrintTableLogRecord::Schema)
+            {
+                break;
+            }
+            Reset();
+            restoringWidths = true;
+        }
+        if (!ReplayLogRecord(kind, data + offset + PRINT_TABLE_LOG_HEADER))
+        {
+            break;
+        }
+        if (kind == PrintTableLogRecord::Schema)
+        {
+            opened->loggedSchema = true;
+        }
+        else if (kind == PrintTableLogRecord::Types)
+        {
+            opened->loggedTypes = true;
+        }
+        else if (kind == PrintTableLogRecord::Widths)
+        {
+            opened->loggedWidthChunks++;
+        }
+        offset += PRINT_TABLE_LOG_HEADER + length;
+    }
+    if (offset == 0 && opened->capacity >= PRINT_TABLE_LOG_HEADER && data[8] != 0)
+    {
+        printf("'%s' is not the log of a table: table '%s' is not made persistent.\n", path.c_str(), title.c_str());
+        return false;
+    }
+    restoringWidths = false;
+    opened->length = offset;
+
+    // Chunks completed after the last Widths record are measured, the others were restored from the log
+    for (size_t i = opened->loggedWidthChunks; i < chunks.size(); i++)
+    {
+        for (size_t c = 0; c < columns.size(); c++)
+        {
+            for (size_t r = i * PRINT_TABLE_CHUNK_ROWS; r < std::min(numRows, (i + 1) * PRINT_TABLE_CHUNK_ROWS); r++)
+            {
+                chunks[i].maxCellWidths[c] = std::max(chunks[i].maxCellWidths[c], PrintTableCellWidth(columns[c], r));
+            }
+        }
+    }
+    for (size_t c = 0; c < columns.size(); c++)
+    {
+        columns[c].maxCellWidth = 0;
+        for (const PrintTableChunk& chunk : chunks)
+        {
+            columns[c].maxCellWidth = std::max(columns[c].maxCellWidth, chunk.maxCellWidths[c]);
+        }
+    }
+    log = opened;
+    return true;
+#else
+    printf("Could not open log '%s' of table '%s': persistent tables need mmap.\n", path.c_str(), title.c_str());
+    return false;
+#endif
+}
+
+bool PrintTable::ReplayLogRecord(PrintTableLogRecord kind, const unsigned char* data)
+{
+    std::string cell;
+    switch (kind)
+    {
+    case PrintTableLogRecord::Schema:
+    {
+        if (!columns.empty())
+        {
+            return false;
+        }
+        const size_t titleLength = PrintTableReadVarint(data);
+        title.assign((const char*)data, titleLength);
+        data += titleLength;
+        const size_t numColumns = PrintTableReadVarint(data);
+        for (size_t c = 0; c < numColumns; c++)
+        {
+            const size_t nameLength = PrintTableReadVarint(data);
+            const std::string name((const char*)data, nameLength);
+            data += nameLength;
+            const PrintTableColumnType type = PrintTableColumnType(*data++);
+            const int fractionDigits = int(PrintTableReadVarint(data));
+            const int64_t utcOffset = int64_t(PrintTableReadVarint(data));
+            if (type == PrintTableColumnType::Timestamp)
+            {
+                AddTimestampColumn(name, fractionDigits);
+                columns.back().utcOffset = utcOffset;
+            }
+            else if (type == PrintTableColumnType::Duration)
+            {
+                AddDurationColumn(name);
+            }
+            else
+            {
+                AddColumn(name);
+            }
+        }
+        if (PrintTableReadLogCell(data, cell) != nullptr)
+        {
+            SetNullMarker(cell);
+        }
+        startedAddingRows = true;
+        return true;
+    }
+    case PrintTableLogRecord::Row:
+        for (PrintTableColumn& column : columns)
+        {
+            const std::string* value = PrintTableReadLogCell(data, cell);
+            if (value == nullptr)
+            {
+                PrintTableAppendValidity(column, false);
+            }
+            else
+            {
+                PrintTableAppendToColumn(column, *value);
+            }
+        }
+        AppendRowMetadata(numRows++);
+        alteredState = true;
+        return true;
+    case PrintTableLogRecord::Types:
+        for (PrintTableColumn& column : columns)
+        {
+            const PrintTableColumnType type = PrintTableColumnType(*data++);
+            const bool typed = *data++ != 0;
+            const int scale = int(PrintTableReadVarint(data));
+            if (!column.typedStorage)
+            {
+                column.type = type;
+                if (typed)
+                {
+                    PrintTableStoreTyped(column, scale);
+                }
+            }
+        }
+        typesInferred = true;
+        RecountResidentBytes();
+        PrintTableRefreshIndexes(*this);
+        return true;
+    case PrintTableLogRecord::Cell:
+    {
+        const size_t row = PrintTableReadVarint(data);
+        const size_t column = PrintTableReadVarint(data);
+        if (row >= numRows || column >= columns.size())
+        {
+            return false;
+        }
+        ChangeCell(row, column, PrintTableReadLogCell(data, cell));
+        return true;
+    }
+    case PrintTableLogRecord::Widths:
+    {
+        const size_t chunk = PrintTableReadVarint(data);
+        if (chunk >= chunks.size())
+        {
+            return false;
+        }
+        for (size_t c = 0; c < columns.size(); c++)
+        {
+            chunks[chunk].maxCellWidths[c] = int(PrintTableReadVarint(data));
+        }
+        return true;
+    }
+    }
+    return false;
+}
+
+void PrintTable::LogRecord(PrintTableLogRecord kind, const std::string& payload)
+{
+    const size_t recordLength = PRINT_TABLE_LOG_HEADER + payload.length();
+    if (log->length + recordLength > log->capacity && !PrintTableMapLog(*log, std::max(log->capacity * 2, log->length + recordLength + (size_t(1) << 20))))
+    {
+        printf("Could not append to the log of table '%s': it is no longer persistent.\n", title.c_str());
+        log.reset();
+        return;
+    }
+    char* record = log->base + log->length;
+    const uint32_t length = uint32_t(payload.length());
+    record[8] = char(kind);
+    memcpy(record + PRINT_TABLE_LOG_HEADER, payload.data(), payload.length());
+    const uint32_t checksum = uint32_t(PrintTableHash(record + 8, payload.length() + 1, 0));
+    memcpy(record, &length, sizeof(length));
+    memcpy(record + 4, &checksum, sizeof(checksum));
+    log->length += recordLength;
+    log->unsyncedRecords++;
+}
+
+void PrintTable::LogRow(const std::vector<std::string>& row)
+{
+    std::string payload;
+    if (!log->loggedSchema)
+    {
+        PrintTableAppendVarint(payload, title.length());
+        payload += title;
+        PrintTableAppendVarint(payload, columns.size());
+        for (size_t c = 0; c < columns.size(); c++)
+        {
+            PrintTableAppendVarint(payload, columnNames[c].length());
+            payload += columnNames[c];
+            payload += char(columns[c].type);
+            PrintTableAppendVarint(payload, columns[c].fractionDigits);
+            PrintTableAppendVarint(payload, uint64_t(columns[c].utcOffset));
+        }
+        PrintTableAppendLogCell(payload, hasNullMarker ? &nullMarker : nullptr);
+        LogRecord(PrintTableLogRecord::Schema, payload);
+        payload.clear();
+        if (!log)
+        {
+            return;
+        }
+        log->loggedSchema = true;
+    }
+    for (const std::string& cell : row)
+    {
+        PrintTableAppendLogCell(payload, hasNullMarker && cell == nullMarker ? nullptr : &cell);
+    }
+    LogRecord(PrintTableLogRecord::Row, payload);
+    // The widths of a chunk are logged once it is complete, changes to its cells are replayed on top of them
+    while (log && log->loggedWidthChunks < numRows / PRINT_TABLE_CHUNK_ROWS)
+    {
+        payload.clear();
+        PrintTableAppendVarint(payload, log->loggedWidthChunks);
+        for (const int width : chunks[log->loggedWidthChunks].maxCellWidths)
+        {
+            PrintTableAppendVarint(payload, width);
+        }
+        LogRecord(PrintTableLogRecord::Widths, payload);
+        if (log)
+        {
+            log->loggedWidthChunks++;
+        }
+    }
+}
+
+void PrintTable::CommitLog()
+{
+    if (log && typesInferred && !log->loggedTypes)
+    {
+        std::string payload;
+        for (const PrintTableColumn& column : columns)
+        {
+            payload += char(column.type);
+            payload += char(column.typedStorage);
+            PrintTableAppendVarint(payload, column.scale);
+        }
+        LogRecord(PrintTableLogRecord::Types, payload);
+        if (log)
+        {
+            log->loggedTypes = true;
+        }
+    }
+    if (log && log->unsyncedRecords >= log->syncRecords)
+    {
+        SyncLog();
+    }
+}
+
+void PrintTable::SyncLog()
+{
+    if (!log || log->unsyncedRecords == 0)
+    {
+        return;
+    }
+    if (!PrintTableSyncFile(log->fd))
+    {
+        printf("Could not sync the log of table '%s' to disk.\n", title.c_str());
+    }
+    log->unsyncedRecords = 0;
+}
+
+#ifdef PRINT_TABLE_POSIX
+PrintTablePublication::~PrintTablePublication()
+{
+    if (base != nullptr)
+    {
+        munmap(base, capacity);
+        shm_unlink(name.c_str());
+    }
+}
+
+bool PrintTable::Publish(const std::string& name, size_t capacity)
+{
+    // Publishing again under the same name replaces the segment, which is unlinked first unless a copy still has it
+    if (publication && publication->name == name)
+    {
+        publication.reset();
+    }
+    // Taking over an existing object would truncate it under its readers and unlink it when done
+    const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0 && errno == EEXIST)
+    {
+        printf("Shared memory object '%s' already exists, table '%s' is not published in it.\n", name.c_str(), title.c_str());
+        return false;
+    }
+    if (fd < 0)
+    {
+        printf("Could not create shared memory object '%s' for table '%s'.\n", name.c_str(), title.c_str());
+        return false;
+    }
+    void* base = ftruncate(fd, capacity) == 0 ? mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+    close(fd);
+    if (base == MAP_FAILED)
+    {
+        printf("Could not map shared memory object '%s' of %lu bytes for table '%s'.\n", name.c_str(), capacity, title.c_str());
+        shm_unlink(name.c_str());
+        return false;
+    }
+    publication = std::make_shared<PrintTablePublication>();
+    publication->name = name;
+    publication->base = (char*)base;
+    publication->capacity = capacity;
+    publication->stale = true;
+    new (base) PrintTableSharedHeader();
+    if (!PublishRows())
+    {
+        printf("Table '%s' does not fit in shared memory object '%s' of %lu bytes.\n", title.c_str(), name.c_str(), capacity);
+        publication.reset();
+        return false;
+    }
+    return true;
+}
+
+static void PrintTableAlign(std::string& block, size_t alignment)
+{
+    block.append((alignment - block.length() % alignment) % alignment, '\0');
+}
+
+bool PrintTable::PublishRows()
+{
+    PrintTablePublication& published = *publication;
+    PrintTableSharedHeader& header = *(PrintTableSharedHeader*)published.base;
+    std::string schema;
+    PrintTableAppendVarint(schema, title.length());
+    schema += title;
+    PrintTableAppendVarint(schema, nullText.length());
+    schema += nullText;
+    PrintTableAppendVarint(schema, columns.size());
+    for (size_t c = 0; c < columns.size(); c++)
+    {
+        PrintTableAppendVarint(schema, columnNames[c].length());
+        schema += columnNames[c];
+        schema += char(IsNumericColumn(c));
+    }
+    // Rows are only added, so they can only fit again once a cell or the schema changes
+    if (published.full && schema == published.schema)
+    {
+        return false;
+    }
+    const bool rebuild = published.stale || schema != published.schema;
+    const size_t firstRow = rebuild ? 0 : published.publishedRows;
+    if (!rebuild && firstRow == numRows)
+    {
+        return true;
+    }
+    if (rebuild)
+    {
+        published.widths.assign(columns.size(), 0);
+    }
+
+    std::string block;
+    const uint64_t blockRows = numRows - firstRow;
+    block.append((const char*)&blockRows, sizeof(blockRows));
+    std::string scratch;
+    std::vector<uint32_t> offsets(blockRows + 1);
+    std::string text;
+    for (size_t c = 0; c < columns.size(); c++)
+    {
+        text.clear();
+        for (size_t r = firstRow; r < numRows; r++)
+        {
+            const std::string& cell = PrintTableIsNull(columns[c], r) ? nullText : PrintTableCellText(columns[c], r, scratch);
+            text += cell;
+            offsets[r - firstRow + 1] = text.length();
+            published.widths[c] = std::max(published.widths[c], int(cell.length()));
+        }
+        block.append((const char*)offsets.data(), offsets.size() * sizeof(uint32_t));
+        block += text;
+        PrintTableAlign(block, sizeof(uint32_t));
+    }
+    PrintTableAlign(block, sizeof(uint64_t));
+
+    std::string head = schema;
+    PrintTableAlign(head, sizeof(int32_t));
+    for (const int width : published.widths)
+    {
+        const int32_t width32 = width;
+        head.append((const char*)&width32, sizeof(width32));
+    }
+    PrintTableAlign(head, sizeof(uint64_t));
+    const size_t firstBlock = sizeof(PrintTableSharedHeader) + head.length();
+    const size_t blockOffset = rebuild ? firstBlock : header.length;
+    if (blockOffset + block.length() > published.capacity)
+    {
+        // Each block repeats the offsets and padding of every column, so all rows in one block may still fit
+        published.stale = true;
+        if (!rebuild)
+        {
+            return PublishRows();
+        }
+        published.full = true;
+        published.schema.swap(schema);
+        return false;
+    }
+
+    // Readers copy the header, schema and widths under the sequence lock, then read the blocks before length
+    // without it. Those are only overwritten by a rebuild, which moves to a new epoch first.
+    const uint64_t sequence = header.sequence.load(std::memory_order_relaxed);
+    header.sequence.store(sequence + 1, std::memory_order_relaxed);
+    if (rebuild)
+    {
+        header.epoch.store(header.epoch.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(published.base + sizeof(PrintTableSharedHeader), head.data(), head.length());
+    memcpy(published.base + blockOffset, block.data(), block.length());
+    header.firstBlock = firstBlock;
+    header.length = blockOffset + block.length();
+    header.numRows = numRows;
+    header.sequence.store(sequence + 2, std::memory_order_release);
+
+    published.schema.swap(schema);
+    published.publishedRows = numRows;
+    published.stale = false;
+    published.full = false;
+    return true;
+}
+
+bool PrintTable::PrintPublished(const std::string& name)
+{
+    const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    struct stat status;
+    if (fd < 0 || fstat(fd, &status) != 0 || size_t(status.st_size) < sizeof(PrintTableSharedHeader))
+    {
+        printf("No table is published as '%s'.\n", name.c_str());
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        return false;
+    }
+    const size_t size = status.st_size;
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        printf("Could not map the table published as '%s'.\n", name.c_str());
+        return false;
+    }
+    const char* base = (const char*)mapping;
+    const PrintTableSharedHeader& header = *(const PrintTableSharedHeader*)base;
+    if (header.magic != PRINT_TABLE_SHARED_MAGIC)
+    {
+        printf("'%s' does not hold a published table.\n", name.c_str());
+        munmap(mapping, size);
+        return false;
+    }
+
+    std::string output;
+    bool consistent = false;
+    for (int attempt = 0; attempt < 1000 && !consistent; attempt++)
+    {
+        const uint64_t sequence = header.sequence.load(std::memory_order_acquire);
+        const uint64_t epoch = header.epoch.load(std::memory_order_relaxed);
+        const size_t firstBlock = header.firstBlock;
+        const size_t length = header.length;
+        if ((sequence & 1) != 0 || firstBlock < sizeof(PrintTableSharedHeader) || firstBlock > length || length > size)
+        {
+            continue;
+        }
+        const std::string head(base + sizeof(PrintTableSharedHeader), firstBlock - sizeof(PrintTableSharedHeader));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (header.sequence.load(std::memory_order_relaxed) != sequence)
+        {
+            continue;
+        }
+
+        const unsigned char* schema = (const unsigned char*)head.data();
+        std::string title;
+        const size_t titleLength = PrintTableReadVarint(schema);
+        title.assign((const char*)schema, titleLength);
+        schema += titleLength;
+        const size_t nullTextLength = PrintTableReadVarint(schema);
+        schema += nullTextLength;
+        const size_t numColumns = PrintTableReadVarint(schema);
+        std::vector<std::string> columnNames(numColumns);
+        std::vector<bool> alignRight(numColumns);
+        for (size_t c = 0; c < numColumns; c++)
+        {
+            const size_t nameLength = PrintTableReadVarint(schema);
+            columnNames[c].assign((const char*)schema, nameLength);
+            schema += nameLength;
+            alignRight[c] = *schema++ != 0;
+        }
+        size_t position = (const char*)schema - head.data();
+        position += (sizeof(int32_t) - position % sizeof(int32_t)) % sizeof(int32_t);
+        std::vector<int> maxColumnWidths(numColumns);
+        for (size_t c = 0; c < numColumns; c++)
+        {
+            int32_t width;
+            memcpy(&width, head.data() + position + c * sizeof(width), sizeof(width));
+            maxColumnWidths[c] = std::max(int(columnNames[c].length()), int(width));
+        }
+
+        int tableWidth = 1;
+        for (const int& width : maxColumnWidths)
+        {
+            tableWidth += width + 3;
+        }
+        const std::string fullDividerStr(tableWidth, '-');
+        output = fullDividerStr + "\n";
+        PrintTableAppendCell(output, title, tableWidth - 4);
+        output += "|\n" + fullDividerStr + "\n";
+        for (size_t c = 0; c < numColumns; c++)
+        {
+            PrintTableAppendCell(output, columnNames[c], maxColumnWidths[c]);
+        }
+        output += "|\n" + fullDividerStr + "\n";
+
+        // Blocks are only trusted as far as they stay inside the snapshot, a rebuild may be overwriting them
+        bool valid = true;
+        std::vector<const uint32_t*> columnOffsets(numColumns);
+        std::vector<const char*> columnText(numColumns);
+        for (size_t offset = firstBlock; offset < length && valid;)
+        {
+            valid = offset + sizeof(uint64_t) <= length;
+            if (!valid)
+            {
+                break;
+            }
+            uint64_t blockRows;
+            memcpy(&blockRows, base + offset, sizeof(blockRows));
+            offset += sizeof(blockRows);
+            for (size_t c = 0; c < numColumns && valid; c++)
+            {
+                valid = blockRows < length && offset + (blockRows + 1) * sizeof(uint32_t) <= length;
+                if (valid)
+                {
+                    columnOffsets[c] = (const uint32_t*)(base + offset);
+                    columnText[c] = base + offset + (blockRows + 1) * sizeof(uint32_t);
+                    offset += (blockRows + 1) * sizeof(uint32_t) + columnOffsets[c][blockRows];
+                    offset += (sizeof(uint32_t) - offset % sizeof(uint32_t)) % sizeof(uint32_t);
+                    valid = offset <= length;
+                }
+            }
+            offset += (sizeof(uint64_t) - offset % sizeof(uint64_t)) % sizeof(uint64_t);
+            for (size_t r = 0; r < blockRows && valid; r++)
+            {
+                for (size_t c = 0; c < numColumns && valid; c++)
+                {
+                    const uint32_t start = columnOffsets[c][r];
+                    const uint32_t end = columnOffsets[c][r + 1];
+                    valid = start <= end && end <= columnOffsets[c][blockRows];
+                    if (valid)
+                    {
+                        PrintTableAppendCell(output, std::string(columnText[c] + start, end - start), maxColumnWidths[c], int(end - start), alignRight[c]);
+                    }
+                }
+                output += "|\n";
+            }
+        }
+        output += fullDividerStr + "\n";
+        std::atomic_thread_fence(std::memory_order_acquire);
+        consistent = valid && header.epoch.load(std::memory_order_relaxed) == epoch;
+    }
+    munmap(mapping, size);
+    if (!consistent)
+    {
+        printf("Could not read a consistent snapshot of the table published as '%s'.\n", name.c_str());
+        return false;
+    }
+    fwrite(output.data(), 1, output.length(), stdout);
+    return true;
+}
+#else
+PrintTablePublication::~PrintTablePublication()
+{
+}
+
+bool PrintTable::Publish(const std::string& name, size_t)
+{
+    printf("Could not publish table '%s' as '%s': publishing needs POSIX shared memory.\n", title.c_str(), name.c_str());
+    return false;
+}
+
+bool PrintTable::PublishRows()
+{
+    return false;
+}
+
+bool PrintTable::PrintPublished(const std::string& name)
+{
+    printf("Could not print the table published as '%s': publishing needs POSIX shared memory.\n", name.c_str());
+    return false;
+}
+#endif
+
+bool PrintTable::ArmEmergencyPrint(int fd, size_t capacity)
+{
+    emergency = std::make_shared<PrintTableEmergency>();
+    emergency->fd = fd;
+    // Filled now, so the pages are already backed by memory when a handler writes them
+    emergency->slots[0].assign(capacity, '\0');
+    emergency->slots[1].assign(capacity, '\0');
+    UpdateEmergencyRender();
+    return true;
+}
+
+void PrintTable::UpdateEmergencyRender()
+{
+    PrintTableEmergency& rendered = *emergency;
+    const int active = rendered.active.load();
+    std::vector<char>& next = rendered.slots[1 - active];
+    const size_t capacity = next.size();
+    size_t length = rendered.lengths[active];
+    size_t changedFrom = length; // Bytes of next before this are the same as in the active slot
+
+    if (title.empty() || columnNames.empty() || numRows == 0 || !BuildFormat())
+    {
+        length = 0;
+        changedFrom = 0;
+        rendered.stale = true;
+    }
+    else
+    {
+        std::string header = fullDividerStr + "\n" + titleStr + "\n" + fullDividerStr + "\n";
+        for (const std::string& groupStr : columnGroupStrs)
+        {
+            header += groupStr + "\n" + fullDividerStr + "\n";
+        }
+        header += columnStr + "\n" + fullDividerStr + "\n";
+        const std::string footer = fullDividerStr + "\n";
+        std::vector<std::string> computedRow(computedColumns.size());
+        std::string rowStr;
+        const auto formatRow = [&](size_t row)
+        {
+            for (size_t k = 0; k < computedColumns.size(); k++)
+            {
+                computedRow[k] = Cell(row, columns.size() + k);
+            }
+            rowStr.clear();
+            AppendRowStr(row, computedRow.data(), rowStr);
+            rowStr += "\n";
+        };
+
+        const bool wasTruncated = rendered.truncated;
+        // Changed rows are rewritten in place unless their length changed, in which case the render is rebuilt
+        bool rebuild = rendered.stale || header != rendered.header || rowFormatKey != rendered.formatKey;
+        for (size_t i = 0; i < rendered.changedRows.size() && !rebuild; i++)
+        {
+            const size_t row = rendered.changedRows[i];
+            if (row + 1 >= rendered.rowOffsets.size())
+            {
+                continue;
+            }
+            formatRow(row);
+            rebuild = rowStr.length() != rendered.rowOffsets[row + 1] - rendered.rowOffsets[row];
+            if (!rebuild)
+            {
+                memcpy(&next[rendered.rowOffsets[row]], rowStr.data(), rowStr.length());
+                changedFrom = std::min(changedFrom, rendered.rowOffsets[row]);
+            }
+        }
+        if (rebuild)
+        {
+            rendered.rowOffsets.assign(1, header.length());
+            rendered.renderedRows = 0;
+            rendered.truncated = header.length() + footer.length() > capacity;
+            changedFrom = 0;
+            if (!rendered.truncated)
+            {
+                memcpy(next.data(), header.data(), header.length());
+            }
+        }
+
+        // Rows are appended where the bottom divider was, as long as the divider still fits after them
+        size_t end = rendered.rowOffsets.back();
+        changedFrom = std::min(changedFrom, end);
+        for (size_t row = rendered.renderedRows; row < numRows && !rendered.truncated; row++)
+        {
+            formatRow(row);
+            if (end + rowStr.length() + footer.length() > capacity)
+            {
+                rendered.truncated = true;
+                break;
+            }
+            memcpy(&next[end], rowStr.data(), rowStr.length());
+            end += rowStr.length();
+            rendered.rowOffsets.push_back(end);
+        }
+        if (rendered.truncated && !wasTruncated)
+        {
+            printf("The emergency render of table '%s' does not fit in %lu bytes: rows from %lu on are left out.\n", title.c_str(), capacity, rendered.rowOffsets.size() - 1);
+        }
+        length = 0;
+        if (header.length() + footer.length() <= capacity)
+        {
+            memcpy(&next[end], footer.data(), footer.length());
+            length = end + footer.length();
+        }
+        rendered.header = header;
+        rendered.formatKey = rowFormatKey;
+        rendered.renderedRows = numRows;
+        rendered.stale = false;
+    }
+    rendered.changedRows.clear();
+
+    // Switch to the updated slot, then bring the other one up to date for the next update
+    rendered.lengths[1 - active] = length;
+    rendered.active.store(1 - active);
+    if (length > changedFrom)
+    {
+        memcpy(&rendered.slots[active][changedFrom], &next[changedFrom], length - changedFrom);
+    }
+    rendered.lengths[active] = length;
+}
+
+#ifdef PRINT_TABLE_POSIX
+void PrintTable::PrintEmergency() const
+{
+    const PrintTableEmergency* rendered = emergency.get();
+    if (rendered == nullptr)
+    {
+        return;
+    }
+    // The handler may have interrupted a call that reads errno afterwards
+    const int savedErrno = errno;
+    const int active = rendered->active.load();
+    const char* data = rendered->slots[active].data();
+    size_t remaining = rendered->lengths[active];
+    while (remaining > 0)
+    {
+        const ssize_t written = write(rendered->fd, data, remaining);
+        if (written < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (written <= 0)
+        {
+            break;
+        }
+        data += written;
+        remaining -= written;
+    }
+    errno = savedErrno;
+}
+#else
+void PrintTable::PrintEmergency() const
+{
+}
+#endif
+
+void PrintTable::SetMemoryBudget(size_t bytes)
+{
+    memoryBudget = bytes;
+    if (memoryBudget > 0 && residentBytes > memoryBudget)
+    {
+        SpillRows();
+    }
+}
+
+void PrintTable::SpillRows()
+{
+    while (!frozen && memoryBudget > 0 && residentBytes > memoryBudget && numRows - sealedRows >= PRINT_TABLE_CHUNK_ROWS)
+    {
+        if (!spillFile)
+        {
+            FILE* file = tmpfile();
+            if (file != nullptr)
+            {
+                spillFile.reset(file, fclose);
+            }
+        }
+        PrintTableChunk& chunk = chunks[sealedRows / PRINT_TABLE_CHUNK_ROWS];
+        // The columns are spilled together, so a failure leaves all of them resident
+        if (!spillFile || !PrintTableSpillChunk(columns, spillFile.get()))
+        {
+            printf("Could not spill rows of table '%s' to disk: the memory budget is no longer enforced.\n", title.c_str());
+            memoryBudget = 0;
+            return;
+        }
+        sealedRows += PRINT_TABLE_CHUNK_ROWS;
+        for (size_t& bytes : chunk.bytes)
+        {
+            residentBytes -= std::min(residentBytes, bytes);
+            bytes = 0;
+        }
+        // Sealed rows are formatted as they are printed
+        chunk.rowStrs.reset();
+        chunk.hasRowStrs = false;
+    }
+}
+
+void PrintTable::EnableCompression(size_t hotRows)
+{
+    compressColdRows = true;
+    this->hotRows = hotRows;
+    CompressRows();
+}
+
+void PrintTable::CompressRows()
+{
+    while (!frozen && compressColdRows && numRows - sealedRows >= hotRows + PRINT_TABLE_CHUNK_ROWS)
+    {
+        PrintTableChunk& chunk = chunks[sealedRows / PRINT_TABLE_CHUNK_ROWS];
+        std::string layout;
+        for (PrintTableColumn& column : columns)
+        {
+            PrintTableSealedChunk sealed;
+            const size_t numValues = PrintTableBuildSealedLayout(column, sealed, layout);
+            std::string compressed;
+            PrintTableCompressChunk(layout, sealed.typed, compressed);
+            compressed.shrink_to_fit();
+            sealed.compressed = std::make_shared<const std::string>(std::move(compressed));
+            PrintTableSealChunk(column, sealed, numValues);
+        }
+        sealedRows += PRINT_TABLE_CHUNK_ROWS;
+        for (size_t& bytes : chunk.bytes)
+        {
+            residentBytes -= std::min(residentBytes, bytes);
+            bytes = 0;
+        }
+        chunk.rowStrs.reset();
+        chunk.hasRowStrs = false;
+    }
+}
+
+void PrintTable::Freeze()
+{
+    if (frozen)
+    {
+        return;
+    }
+    // All columns are built before any is replaced, so a column that does not fit leaves the table as it was
+    std::vector<std::shared_ptr<PrintTableFrozenCells>> frozenColumns;
+    std::string scratch;
+    for (const PrintTableColumn& column : columns)
+    {
+        // Distinct texts, until there are more than the codes can tell apart
+        std::unordered_map<std::string, uint32_t> dictionary;
+        bool useDictionary = true;
+        size_t numValues = 0;
+        size_t textBytes = 0;
+        size_t dictionaryBytes = 0;
+        for (size_t r = 0; r < numRows; r++)
+        {
+            if (PrintTableIsNull(column, r))
+            {
+                continue;
+            }
+            const std::string& cell = PrintTableCellText(column, r, scratch);
+            numValues++;
+            textBytes += cell.length();
+            if (useDictionary && dictionary.emplace(cell, uint32_t(dictionary.size())).second)
+            {
+                dictionaryBytes += cell.length();
+                useDictionary = dictionary.size() <= size_t(UINT16_MAX) + 1;
+            }
+        }
+        // A 2 byte code per cell instead of a 4 byte offset only pays off if the distinct texts are few or short
+        useDictionary = useDictionary && dictionaryBytes + dictionary.size() * sizeof(uint32_t) < textBytes + numValues * (sizeof(uint32_t) - sizeof(uint16_t));
+        if ((useDictionary ? dictionaryBytes : textBytes) > UINT32_MAX)
+        {
+            printf("Table '%s' has a column with more than 4 GB of text, which cannot be frozen.\n", title.c_str());
+            return;
+        }
+
+        std::shared_ptr<PrintTableFrozenCells> frozenColumn = std::make_shared<PrintTableFrozenCells>();
+        if (useDictionary)
+        {
+            std::vector<const std::string*> texts(dictionary.size());
+            for (const std::pair<const std::string, uint32_t>& entry : dictionary)
+            {
+                texts[entry.second] = &entry.first;
+            }
+            frozenColumn->blob.reserve(dictionaryBytes);
+            for (const std::string* text : texts)
+            {
+                frozenColumn->offsets.push_back(frozenColumn->blob.length());
+                frozenColumn->blob += *text;
+            }
+            frozenColumn->codes.reserve(numValues);
+        }
+        else
+        {
+            frozenColumn->blob.reserve(textBytes);
+            frozenColumn->offsets.reserve(numValues + 1);
+        }
+        for (size_t r = 0; r < numRows; r++)
+        {
+            if (PrintTableIsNull(column, r))
+            {
+                continue;
+            }
+            const std::string& cell = PrintTableCellText(column, r, scratch);
+            if (useDictionary)
+            {
+                frozenColumn->codes.push_back(uint16_t(dictionary[cell]));
+                continue;
+            }
+            frozenColumn->offsets.push_back(frozenColumn->blob.length());
+            frozenColumn->blob += cell;
+        }
+        frozenColumn->offsets.push_back(frozenColumn->blob.length());
+        frozenColumns.push_back(frozenColumn);
+    }
+
+    for (size_t c = 0; c < columns.size(); c++)
+    {
+        PrintTableColumn& column = columns[c];
+        column.frozen = frozenColumns[c];
+        column.cells.Clear();
+        column.numbers.Clear();
+        column.typedStorage = false;
+        std::vector<PrintTableSealedChunk>().swap(column.sealedChunks);
+        column.sealedRows = 0;
+        column.sealedValues = 0;
+        column.decompressedChunk = size_t(-1);
+        std::string().swap(column.decompressed);
+    }
+    // Rows are formatted from the blobs as they are printed, like sealed rows, instead of being kept formatted
+    for (PrintTableChunk& chunk : chunks)
+    {
+        chunk.bytes.assign(columns.size(), 0);
+        chunk.rowStrs.reset();
+        chunk.hasRowStrs = false;
+    }
+    sealedRows = 0;
+    residentBytes = 0;
+    memoryBudget = 0;
+    compressColdRows = false;
+    spillFile.reset();
+    startedAddingRows = true;
+    frozen = true;
+}
+
+void PrintTable::SetCell(size_t row, size_t column, const std::string& value)
+{
+    ChangeCell(row, column, hasNullMarker && value == nullMarker ? nullptr : &value);
+}
+
+void PrintTable::SetNull(size_t row, size_t column)
+{
+    ChangeCell(row, column, nullptr);
+}
+
+void PrintTable::ChangeCell(size_t row, size_t column, const std::string* value)
+{
+    if (row >= numRows || column >= columnNames.size())
+    {
+        printf("Cell (%lu, %lu) is outside of table '%s' which has %lu rows and %lu columns.\n", row, column, title.c_str(), numRows, columnNames.size());
+        return;
+    }
+    if (frozen)
+    {
+        printf("Table '%s' is frozen: row %lu can no longer be changed.\n", title.c_str(), row);
+        return;
+    }
+    if (row < columns[column].sealedRows)
+    {
+        printf("Row %lu of table '%s' was sealed by spilling or compression and can no longer be changed.\n", row, title.c_str());
+        return;
+    }
+    PrintTableColumn& changedColumn = columns[column];
+    std::string scratch;
+    const bool wasNull = PrintTableIsNull(changedColumn, row);
+    const std::string& previous = PrintTableCellText(changedColumn, row, scratch);
+    for (PrintTableColumnIndex& index : columnIndexes)
+    {
+        if (index.column == column && !wasNull)
+        {
+            PrintTableIndexErase(index, previous, row);
+        }
+    }
+    const int previousLength = previous.length();
+    PrintTableChunk& chunk = chunks[row / PRINT_TABLE_CHUNK_ROWS];
+    residentBytes -= std::min(residentBytes, PrintTableCellBytes(changedColumn, row));
+    chunk.bytes[column] -= std::min(chunk.bytes[column], PrintTableCellBytes(changedColumn, row));
+    PrintTableStoreCell(changedColumn, row, value);
+    residentBytes += PrintTableCellBytes(changedColumn, row);
+    chunk.bytes[column] += PrintTableCellBytes(changedColumn, row);
+
+    // The cell is indexed and measured as it is printed, which differs from value for time columns.
+    // Null cells are printed as nullText, which is accounted for when printing, so they count as empty here.
+    const std::string& current = PrintTableCellText(changedColumn, row, scratch);
+    if (int(current.length()) >= chunk.maxCellWidths[column])
+    {
+        chunk.maxCellWidths[column] = current.length();
+        changedColumn.maxCellWidth = std::max(changedColumn.maxCellWidth, int(current.length()));
+    }
+    else if (previousLength == chunk.maxCellWidths[column])
+    {
+        chunk.widthsDirty = true;
+        cellWidthsDirty = true;
+    }
+    for (PrintTableColumnIndex& index : columnIndexes)
+    {
+        if (index.column == column && PrintTableIndexStale(*this, index))
+        {
+            PrintTableBuildIndex(*this, index);
+        }
+        else if (index.column == column && value != nullptr)
+        {
+            PrintTableIndexInsert(index, current, row);
+        }
+    }
+    // The sketches cannot forget the old value, so the new one is only added
+    if (!columnStats.empty() && value != nullptr)
+    {
+        PrintTableAddToStats(columnStats[column], current, statsTopN);
+    }
+    for (PrintTableComputedColumn& computed : computedColumns)
+    {
+        computed.dirty = true;
+    }
+    rowsFingerprint -= PrintTableRowsFingerprintTerm(rowFingerprints[row], row);
+    chunk.fingerprint -= PrintTableRowsFingerprintTerm(rowFingerprints[row], row);
+    rowFingerprints.Mutable(row) = PrintTableRowFingerprint(*this, row);
+    rowsFingerprint += PrintTableRowsFingerprintTerm(rowFingerprints[row], row);
+    chunk.fingerprint += PrintTableRowsFingerprintTerm(rowFingerprints[row], row);
+    // Stale postings cannot be removed without knowing which other cells of the row share the trigram,
+    // so the trigram index is rebuilt by the next search instead
+    if (trigramIndex.built && std::find(trigramIndex.columns.begin(), trigramIndex.columns.end(), column) != trigramIndex.columns.end())
+    {
+        trigramIndex.postings.clear();
+        trigramIndex.built = false;
+    }
+    alteredState = true;
+    if (log)
+    {
+        std::string payload;
+        PrintTableAppendVarint(payload, row);
+        PrintTableAppendVarint(payload, column);
+        PrintTableAppendLogCell(payload, value);
+        LogRecord(PrintTableLogRecord::Cell, payload);
+        CommitLog();
+    }
+    if (publication)
+    {
+        publication->stale = publication->stale || row < publication->publishedRows;
+        publication->full = false;
+        PublishRows();
+    }
+    if (emergency)
+    {
+        emergency->changedRows.push_back(row);
+        UpdateEmergencyRender();
+    }
+}
+
+void PrintTable::SetNullText(const std::string& text)
+{
+    nullText = text;
+    alteredState = true;
+    if (publication)
+    {
+        PublishRows();
+    }
+    if (emergency)
+    {
+        emergency->stale = true;
+        UpdateEmergencyRender();
+    }
+}
+
+void PrintTable::SetNullMarker(const std::string& marker)
+{
+    nullMarker = marker;
+    hasNullMarker = true;
+}
+
+void PrintTable::CreateTrigramIndex(const std::vector<std::string>& indexedColumns)
+{
+    trigramIndex = PrintTableTrigramIndex();
+    for (const std::string& column : indexedColumns)
+    {
+        const int index = FindColumn(column);
+        if (index < 0)
+        {
+            printf("Column '%s' does not exist in table '%s'.\n", column.c_str(), title.c_str());
+            return;
+        }
+        trigramIndex.columns.push_back(index);
+    }
+    if (trigramIndex.columns.empty())
+    {
+        for (size_t c = 0; c < columnNames.size(); c++)
+        {
+            trigramIndex.columns.push_back(c);
+        }
+    }
+    trigramIndex.enabled = true;
+}
+
+// Returns the rows that contain every trigram of pattern in the indexed columns, in ascending order
+static std::vector<uint32_t> PrintTableTrigramCandidates(const PrintTableTrigramIndex& index, const std::string& pattern)
+{
+    std::vector<const std::vector<uint32_t>*> postings;
+    for (size_t i = 0; i + 3 <= pattern.length(); i++)
+    {
+        const uint32_t trigram = uint32_t((unsigned char)pattern[i]) << 16 | uint32_t((unsigned char)pattern[i + 1]) << 8 | uint32_t((unsigned char)pattern[i + 2]);
+        const auto it = index.postings.find(trigram);
+        if (it == index.postings.end())
+        {
+            return {};
+        }
+        postings.push_back(&it->second);
+    }
+    // Intersect starting with the shortest list so the candidates shrink as fast as possible
+    std::sort(postings.begin(), postings.end(), [](const std::vector<uint32_t>* a, const std::vector<uint32_t>* b) { return a->size() < b->size(); });
+    std::vector<uint32_t> candidates = *postings[0];
+    std::vector<uint32_t> intersection;
+    for (size_t p = 1; p < postings.size() && !candidates.empty(); p++)
+    {
+        if (postings[p] == postings[p - 1])
+        {
+            continue;
+        }
+        intersection.clear();
+        std::set_intersection(candidates.begin(), candidates.end(), postings[p]->begin(), postings[p]->end(), std::back_inserter(intersection));
+        candidates.swap(intersection);
+    }
+    return candidates;
+}
+
+bool PrintTable::BuildFormat()
+{
+    if (title.empty() || columnNames.empty() || numRows == 0)
+    {
+        printf("Missing some necessary data to print table:\n\tTitle: '%s' (must not be empty)\n\tNumber of columns: %lu (min=1)\n\tNumber of rows: %lu (min=1)\n", title.c_str(), columnNames.size(), numRows);
+        return false;
+    }
+    // Content that is identical to what the format data was built from, e.g. a cell changed and changed back,
+    // does not need its format rebuilt
+    const uint64_t fingerprint = Fingerprint();
+    if (alteredState && !(hasFormat && fingerprint == formattedFingerprint))
+    {
+        // The widest cell of each column is only unknown if one was shortened by SetCell.
+        // Only the chunks it was shortened in are scanned again, the other chunks still know their widths.
+        if (cellWidthsDirty)
+        {
+            for (size_t i = 0; i < chunks.size(); i++)
+            {
+                if (!chunks[i].widthsDirty)
+                {
+                    continue;
+                }
+                for (size_t c = 0; c < columns.size(); c++)
+                {
+                    chunks[i].maxCellWidths[c] = 0;
+                    for (size_t r = i * PRINT_TABLE_CHUNK_ROWS; r < std::min(numRows, (i + 1) * PRINT_TABLE_CHUNK_ROWS); r++)
+                    {
+                        chunks[i].maxCellWidths[c] = std::max(chunks[i].maxCellWidths[c], PrintTableCellWidth(columns[c], r));
+                    }
+                }
+                chunks[i].widthsDirty = false;
+            }
+            for (size_t c = 0; c < columns.size(); c++)
+            {
+                columns[c].maxCellWidth = 0;
+                for (const PrintTableChunk& chunk : chunks)
+                {
+                    columns[c].maxCellWidth = std::max(columns[c].maxCellWidth, chunk.maxCellWidths[c]);
+                }
+            }
+            cellWidthsDirty = false;
+        }
+
+        // Computed columns are only formatted now that they are printed
+        EvaluateComputedColumns();
+
+        // Find max width of each column
+        const size_t numColumns = NumColumns();
+        maxColumnWidths.resize(numColumns);
+        for (size_t i = 0; i < columns.size(); i++)
+        {
+            maxColumnWidths[i] = std::max(int(columnNames[i].length()), columns[i].maxCellWidth);
+            if (columns[i].nullCount > 0)
+            {
+                maxColumnWidths[i] = std::max(maxColumnWidths[i], int(nullText.length()));
+            }
+        }
+        for (size_t k = 0; k < computedColumns.size(); k++)
+        {
+            int& width = maxColumnWidths[columns.size() + k];
+            width = computedColumns[k].name.length();
+            // Visuals have a fixed width, window functions keep track of their widest value
+            width = std::max(width, computedColumns[k].visual != PrintTableVisual::None ? computedColumns[k].width : computedColumns[k].maxCellWidth);
+        }
+
+        // Widen the columns under a group whose name is longer than the columns it spans.
+        // Lower levels are handled first as widening them can only make higher levels fit better.
+        size_t numGroupLevels = 0;
+        for (const PrintTableColumnGroup& group : columnGroups)
+        {
+            numGroupLevels = std::max(numGroupLevels, group.level + 1);
+        }
+        for (size_t level = 0; level < numGroupLevels; level++)
+        {
+            for (const PrintTableColumnGroup& group : columnGroups)
+            {
+                if (group.level != level)
+                {
+                    continue;
+                }
+                int childrenWidth = 0;
+                for (size_t c = group.firstColumn; c < group.firstColumn + group.numColumns; c++)
+                {
+                    childrenWidth += maxColumnWidths[c];
+                }
+                // The separators between the children also belong to the group
+                const int spanWidth = childrenWidth + 3 * int(group.numColumns - 1);
+                const int missingWidth = int(group.name.length()) - spanWidth;
+                if (missingWidth <= 0)
+                {
+                    continue;
+                }
+                // Distribute the missing width proportionally to the width of each child.
+                // Whatever is lost to rounding is given to the last child.
+                int distributed = 0;
+                for (size_t c = group.firstColumn; c < group.firstColumn + group.numColumns; c++)
+                {
+                    const int extra = childrenWidth > 0 ? (missingWidth * maxColumnWidths[c]) / childrenWidth : 0;
+                    maxColumnWidths[c] += extra;
+                    distributed += extra;
+                }
+                maxColumnWidths[group.firstColumn + group.numColumns - 1] += missingWidth - distributed;
+            }
+        }
+
+        /*
+        -------------------------------
+        |          Test table         |
+        -------------------------------
+        |        Group0     |         |
+        -------------------------------
+        | column0 | column1 | column2 |
+        -------------------------------
+        |  row0   |  row0   |  row0   |
+        |-----------------------------|
+        |  row1   |  row1   |  row1   |
+        |-----------------------------|
+        |  row2   |  row2   |  row2   |
+        -------------------------------
+        */
+        int tableWidth = 0;
+        for (const int& width : maxColumnWidths)
+        {
+            // +3 because it includes the space for the first |
+            // and a space on each side of the column name (see above example)
+            tableWidth += width + 3;
+        }
+        // Make space for the last |
+        tableWidth += 1;
+        fullDividerStr = std::string(tableWidth, '-');
+
+        // Create string with title
+        // Subtract 4 to ensure that the inital, and last, | and space are ignored
+        titleStr = "";
+        PrintTableAppendCell(titleStr, title, tableWidth - 4);
+        titleStr += "|";
+
+        // Create string for each level of column groups, top level first.
+        // Columns not covered by a group on a level get an empty cell.
+        columnGroupStrs = std::vector<std::string>(numGroupLevels);
+        for (size_t level = 0; level < numGroupLevels; level++)
+        {
+            std::string& groupStr = columnGroupStrs[numGroupLevels - 1 - level];
+            size_t c = 0;
+            while (c < numColumns)
+            {
+                const PrintTableColumnGroup* startingGroup = nullptr;
+                for (const PrintTableColumnGroup& group : columnGroups)
+                {
+                    if (group.level == level && group.firstColumn == c)
+                    {
+                        startingGroup = &group;
+                        break;
+                    }
+                }
+                if (startingGroup == nullptr)
+                {
+                    PrintTableAppendCell(groupStr, "", maxColumnWidths[c]);
+                    c++;
+                    continue;
+                }
+                int spanWidth = 3 * int(startingGroup->numColumns - 1);
+                for (size_t g = 0; g < startingGroup->numColumns; g++)
+                {
+                    spanWidth += maxColumnWidths[c + g];
+                }
+                PrintTableAppendCell(groupStr, startingGroup->name, spanWidth);
+                c += startingGroup->numColumns;
+            }
+            groupStr += "|";
+        }
+
+        // Create string with each column name
+        columnStr = "";
+        for (size_t i = 0; i < numColumns; i++)
+        {
+            PrintTableAppendCell(columnStr, ColumnName(i), maxColumnWidths[i]);
+        }
+        columnStr += "|";
+
+        // The row strings of a chunk stay valid as long as its cells and everything hashed here stay the same
+        rowFormatKey = PrintTableHash(nullText.data(), nullText.length(), 0);
+        for (size_t c = 0; c < numColumns; c++)
+        {
+            rowFormatKey = PrintTableMix(rowFormatKey ^ (uint64_t(maxColumnWidths[c]) << 1 | (IsNumericColumn(c) ? 1 : 0)));
+        }
+        for (const PrintTableComputedColumn& computed : computedColumns)
+        {
+            // Visuals are scaled to the range of the values, which appending rows can change
+            uint64_t minBits = 0;
+            uint64_t maxBits = 0;
+            memcpy(&minBits, &computed.minValue, sizeof(minBits));
+            memcpy(&maxBits, &computed.maxValue, sizeof(maxBits));
+            rowFormatKey = PrintTableMix(rowFormatKey ^ computed.evaluations);
+            rowFormatKey = computed.visual == PrintTableVisual::None ? rowFormatKey : PrintTableMix(rowFormatKey ^ minBits ^ PrintTableMix(maxBits));
+        }
+    }
+    alteredState = false;
+    formattedFingerprint = fingerprint;
+    hasFormat = true;
+    return true;
+}
+
+const std::vector<std::string>& PrintTable::ChunkRowStrs(size_t i, std::vector<std::string>& scratch)
+{
+    PrintTableChunk& chunk = chunks[i];
+    const size_t firstRow = i * PRINT_TABLE_CHUNK_ROWS;
+    const size_t endRow = std::min(numRows, firstRow + PRINT_TABLE_CHUNK_ROWS);
+    const uint64_t key = PrintTableMix(chunk.fingerprint ^ rowFormatKey);
+    const bool sealed = firstRow < sealedRows || frozen;
+    if (!sealed && chunk.hasRowStrs && chunk.formattedKey == key)
+    {
+        return *chunk.rowStrs;
+    }
+    // Copies of the table may still print the rows formatted before, so those are left to them
+    if (!sealed && (!chunk.rowStrs || chunk.rowStrs.use_count() > 1))
+    {
+        chunk.rowStrs = std::make_shared<std::vector<std::string>>();
+    }
+    std::vector<std::string>& rowStrs = sealed ? scratch : *chunk.rowStrs;
+    rowStrs.resize(endRow - firstRow);
+    std::vector<std::string> computedRow(computedColumns.size());
+    for (size_t r = firstRow; r < endRow; r++)
+    {
+        for (size_t k = 0; k < computedColumns.size(); k++)
+        {
+            computedRow[k] = Cell(r, columns.size() + k);
+        }
+        rowStrs[r - firstRow].clear();
+        AppendRowStr(r, computedRow.data(), rowStrs[r - firstRow]);
+    }
+    if (!sealed)
+    {
+        chunk.formattedKey = key;
+        chunk.hasRowStrs = true;
+    }
+    return rowStrs;
+}
+
+void PrintTable::Print()
+{
+    if (!BuildFormat())
+    {
+        return;
+    }
+    printf("%s\n", fullDividerStr.c_str());
+    printf("%s\n", titleStr.c_str());
+    printf("%s\n", fullDividerStr.c_str());
+    for (const std::string& groupStr : columnGroupStrs)
+    {
+        printf("%s\n", groupStr.c_str());
+        printf("%s\n", fullDividerStr.c_str());
+    }
+    printf("%s\n", columnStr.c_str());
+    printf("%s\n", fullDividerStr.c_str());
+    // Sealed rows are formatted a chunk at a time and not kept, so the kernel can evict their mapped chunks again
+    std::vector<std::string> sealedRowStrs;
+    for (size_t i = 0; i < chunks.size(); i++)
+    {
+        for (const std::string& rowStr : ChunkRowStrs(i, sealedRowStrs))
+        {
+            printf("%s\n", rowStr.c_str());
+        }
+    }
+    printf("%s\n", fullDividerStr.c_str());
+    printedFingerprint = formattedFingerprint;
+    hasPrinted = true;
+}
+
+void PrintTable::AppendRowStr(size_t row, const std::string* computedRow, std::string& rowStr) const
+{
+    std::string scratch;
+    for (size_t c = 0; c < columns.size(); c++)
+    {
+        // Frozen cells are appended straight from their blob
+        if (columns[c].frozen && !PrintTableIsNull(columns[c], row))
+        {
+            const char* text;
+            size_t length;
+            PrintTableFrozenText(*columns[c].frozen, PrintTableValueIndex(columns[c], row), text, length);
+            PrintTableAppendCell(rowStr, text, length, maxColumnWidths[c], int(length), IsNumericColumn(c));
+            continue;
+        }
+        const std::string& cell = PrintTableIsNull(columns[c], row) ? nullText : PrintTableCellText(columns[c], row, scratch);
+        PrintTableAppendCell(rowStr, cell, maxColumnWidths[c], int(cell.length()), IsNumericColumn(c));
+    }
+    for (size_t k = 0; k < computedColumns.size(); k++)
+    {
+        const std::string& cell = computedRow[k];
+        const int cellWidth = computedColumns[k].visual != PrintTableVisual::None ? computedColumns[k].width : int(cell.length());
+        PrintTableAppendCell(rowStr, cell, maxColumnWidths[columns.size() + k], cellWidth, IsNumericColumn(columns.size() + k));
+    }
+    rowStr += "|";
+}
+
+bool PrintTable::PrintIfChanged()
+{
+    if (hasPrinted && Fingerprint() == printedFingerprint)
+    {
+        return false;
+    }
+    Print();
+    return true;
+}
+
+void PrintTable::Reset()
+{
+    title = "";
+    columnNames.resize(0);
+    columnGroups.resize(0);
+    columns.resize(0);
+    computedColumns.resize(0);
+    numRows = 0;
+    cellWidthsDirty = false;
+    rowFingerprints.Clear();
+    rowsFingerprint = 0;
+    trigramIndex = PrintTableTrigramIndex();
+    columnIndexes.resize(0);
+    typesInferred = false;
+    columnStats.resize(0);
+    nullText = "-";
+    nullMarker = "";
+    hasNullMarker = false;
+    memoryBudget = 0;
+    residentBytes = 0;
+    sealedRows = 0;
+    frozen = false;
+    spillFile.reset();
+    compressColdRows = false;
+    hotRows = 0;
+    log.reset();
+    publication.reset();
+    chunks.resize(0);
+    statsTopN = 0;
+    maxColumnWidths.resize(0);
+    // The format data was just cleared, so it must be rebuilt even if the same content is added again
+    hasFormat = false;
+    formattedFingerprint = 0;
+    startedAddingRows = false;
+    alteredState = true;
+    // The table stays armed, with an empty render until it has rows again
+    if (emergency)
+    {
+        emergency->stale = true;
+        UpdateEmergencyRender();
+    }
+}
+
+uint64_t PrintTable::Fingerprint() const
+{
+    uint64_t fingerprint = PrintTableHash(title.data(), title.length(), rowsFingerprint);
+    for (const std::string& columnName : columnNames)
+    {
+        fingerprint = PrintTableHash(columnName.data(), columnName.length(), fingerprint);
+    }
+    for (const PrintTableComputedColumn& computed : computedColumns)
+    {
+        fingerprint = PrintTableHash(computed.name.data(), computed.name.length(), fingerprint);
+        fingerprint = PrintTableMix(fingerprint ^ (uint64_t(computed.function) << 48 | computed.valueColumn << 32 | uint64_t(computed.orderColumn + 1) << 16 | uint64_t(computed.partitionColumn + 1)));
+        fingerprint = PrintTableMix(fingerprint ^ (uint64_t(computed.visual) << 32 | uint64_t(computed.width)));
+    }
+    for (const PrintTableColumnGroup& group : columnGroups)
+    {
+        fingerprint = PrintTableHash(group.name.data(), group.name.length(), fingerprint);
+        fingerprint = PrintTableMix(fingerprint ^ (group.firstColumn << 32 | group.numColumns << 16 | group.level));
+    }
+    return PrintTableHash(nullText.data(), nullText.length(), fingerprint);
+}
+
+size_t PrintTable::NumRows() const
+{
+    return numRows;
+}
+
+size_t PrintTable::NumColumns() const
+{
+    return columns.size() + computedColumns.size();
+}
+
+const std::string& PrintTable::ColumnName(size_t column) const
+{
+    return column < columns.size() ? columnNames[column] : computedColumns[column - columns.size()].name;
+}
+
+std::string PrintTable::Cell(size_t row, size_t column) const
+{
+    if (column < columns.size())
+    {
+        std::string scratch;
+        return PrintTableIsNull(columns[column], row) ? nullText : PrintTableCellText(columns[column], row, scratch);
+    }
+    EvaluateComputedColumns();
+    const PrintTableComputedColumn& computed = computedColumns[column - columns.size()];
+    if (computed.visual == PrintTableVisual::None)
+    {
+        return computed.valid[row] ? PrintTableFormatNumber(computed.values[row]) : std::string();
+    }
+
+    // Each value is scaled to a glyph level, so drawing it is a table lookup and a copy
+    const double range = computed.maxValue - computed.minValue;
+    const int maxLevel = computed.visual == PrintTableVisual::Bar ? computed.width * 8 : 7;
+    const auto level = [&](size_t r)
+    {
+        return range > 0.0 ? int((computed.values[r] - computed.minValue) / range * maxLevel + 0.5) : maxLevel;
+    };
+    if (computed.visual == PrintTableVisual::Bar)
+    {
+        return computed.valid[row] ? computed.glyphs[level(row)] : std::string(computed.width, ' ');
+    }
+    std::string sparkline;
+    const size_t first = row + 1 >= size_t(computed.width) ? row + 1 - computed.width : 0;
+    sparkline.append(computed.width - (row + 1 - first), ' ');
+    for (size_t r = first; r <= row; r++)
+    {
+        if (computed.valid[r])
+        {
+            sparkline += computed.glyphs[level(r)];
+        }
+        else
+        {
+            sparkline += ' ';
+        }
+    }
+    return sparkline;
+}
+
+bool PrintTable::IsNull(size_t row, size_t column) const
+{
+    return column < columns.size() && PrintTableIsNull(columns[column], row);
+}
+
+int PrintTable::CellWidth(size_t row, size_t column) const
+{
+    if (column >= columns.size() && computedColumns[column - columns.size()].visual != PrintTableVisual::None)
+    {
+        return computedColumns[column - columns.size()].width;
+    }
+    return Cell(row, column).length();
+}
+
+int PrintTable::FindColumn(const std::string& columnName) const
+{
+    for (size_t i = 0; i < columnNames.size(); i++)
+    {
+        if (columnNames[i] == columnName)
+        {
+            return int(i);
+        }
+    }
+    return -1;
+}
+
+// Creates a view with all the columns of table and no rows
+static PrintTableView PrintTableSelection(const PrintTable& table)
+{
+    PrintTableView view;
+    view.title = table.title;
+    view.tables = { &table };
+    for (size_t c = 0; c < table.NumColumns(); c++)
+    {
+        view.columnNames.push_back(table.ColumnName(c));
+        view.columnTables.push_back(0);
+        view.columnSources.push_back(c);
+    }
+    return view;
+}
+
+void PrintTable::CreateIndex(const std::string& column, PrintTableIndexKind kind)
+{
+    const int columnIndex = FindColumn(column);
+    if (columnIndex < 0)
+    {
+        printf("Column '%s' does not exist in table '%s'.\n", column.c_str(), title.c_str());
+        return;
+    }
+    PrintTableColumnIndex index;
+    index.column = columnIndex;
+    index.kind = kind;
+    PrintTableBuildIndex(*this, index);
+    columnIndexes.push_back(std::move(index));
+}
+
+PrintTableView PrintTable::Lookup(const std::string& column, const std::string& value) const
+{
+    PrintTableView view = PrintTableSelection(*this);
+    const int columnIndex = FindColumn(column);
+    if (columnIndex < 0)
+    {
+        printf("Column '%s' does not exist in table '%s'.\n", column.c_str(), title.c_str());
+        return view;
+    }
+    for (const PrintTableColumnIndex& index : columnIndexes)
+    {
+        if (index.column != size_t(columnIndex))
+        {
+            continue;
+        }
+        int64_t number;
+        if (index.kind == PrintTableIndexKind::Hash)
+        {
+            const auto it = index.hash.find(value);
+            if (it != index.hash.end())
+            {
+                view.rowSources = it->second;
+            }
+        }
+        else if (index.numeric && PrintTableParseScaled(value, index.scale, number))
+        {
+            const auto range = index.sortedNumbers.equal_range(number);
+            for (auto it = range.first; it != range.second; ++it)
+            {
+                view.rowSources.push_back(it->second);
+            }
+        }
+        else
+        {
+            const auto range = index.sorted.equal_range(value);
+            for (auto it = range.first; it != range.second; ++it)
+            {
+                view.rowSources.push_back(it->second);
+            }
+        }
+        // Present the rows in table order no matter how the index stores them
+        std::sort(view.rowSources.begin(), view.rowSources.end());
+        return view;
+    }
+    // No index on the column, fall back to a scan
+    std::string scratch;
+    for (size_t r = 0; r < numRows; r++)
+    {
+        if (!PrintTableIsNull(columns[columnIndex], r) && PrintTableCellText(columns[columnIndex], r, scratch) == value)
+        {
+            view.rowSources.push_back(r);
+        }
+    }
+    return view;
+}
+
+PrintTableView PrintTable::Range(const std::string& column, const std::string& low, const std::string& high) const
+{
+    PrintTableView view = PrintTableSelection(*this);
+    const int columnIndex = FindColumn(column);
+    if (columnIndex < 0)
+    {
+        printf("Column '%s' does not exist in table '%s'.\n", column.c_str(), title.c_str());
+        return view;
+    }
+    for (const PrintTableColumnIndex& index : columnIndexes)
+    {
+        if (index.column == size_t(columnIndex) && index.kind == PrintTableIndexKind::Sorted && index.numeric)
+        {
+            int64_t lowNumber;
+            int64_t highNumber;
+            if (!PrintTableIndexBound(low, index.scale, false, lowNumber) || !PrintTableIndexBound(high, index.scale, true, highNumber))
+            {
+                printf("Range ['%s', '%s'] on numeric column '%s' of table '%s' must be bounded by numbers.\n", low.c_str(), high.c_str(), column.c_str(), title.c_str());
+                return view;
+            }
+            const auto end = index.sortedNumbers.upper_bound(highNumber);
+            for (auto it = index.sortedNumbers.lower_bound(lowNumber); it != end && lowNumber <= highNumber; ++it)
+            {
+                view.rowSources.push_back(it->second);
+            }
+            return view;
+        }
+        if (index.column == size_t(columnIndex) && index.kind == PrintTableIndexKind::Sorted)
+        {
+            const auto end = index.sorted.upper_bound(high);
+            for (auto it = index.sorted.lower_bound(low); it != end && low <= high; ++it)
+            {
+                view.rowSources.push_back(it->second);
+            }
+            return view;
+        }
+    }
+    // No sorted index on the column, fall back to a scan and sort the matches
+    // Like sorted indexes, cells stored as numbers are compared as numbers
+    const PrintTableColumn& scanned = columns[columnIndex];
+    if (scanned.typedStorage)
+    {
+        double lowNumber;
+        double highNumber;
+        if (!PrintTableParseNumber(low, lowNumber) || !PrintTableParseNumber(high, highNumber))
+        {
+            printf("Range ['%s', '%s'] on numeric column '%s' of table '%s' must be bounded by numbers.\n", low.c_str(), high.c_str(), column.c_str(), title.c_str());
+            return view;
+        }
+        std::vector<double> numbers(numRows);
+        for (size_t r = 0; r < numRows; r++)
+        {
+            if (PrintTableCellNumber(scanned, r, numbers[r]) && numbers[r] >= lowNumber && numbers[r] <= highNumber)
+            {
+                view.rowSources.push_back(r);
+            }
+        }
+        std::stable_sort(view.rowSources.begin(), view.rowSources.end(), [&](size_t a, size_t b) { return numbers[a] < numbers[b]; });
+        return view;
+    }
+    PrintTableCowVector<std::string> scratch;
+    const PrintTableCowVector<std::string>& cells = PrintTableColumnCells(*this, columnIndex, scratch);
+    for (size_t r = 0; r < numRows; r++)
+    {
+        if (!PrintTableIsNull(columns[columnIndex], r) && cells[r] >= low && cells[r] <= high)
+        {
+            view.rowSources.push_back(r);
+        }
+    }
+    std::stable_sort(view.rowSources.begin(), view.rowSources.end(), [&](size_t a, size_t b) { return cells[a] < cells[b]; });
+    return view;
+}
+
+// Marks the rows whose cell in a frozen column contains pattern, which must not be empty
+static void PrintTableFrozenMatches(const PrintTableColumn& column, const std::string& pattern, std::vector<bool>& matches)
+{
+    // Find the texts containing pattern in one pass over the blob. A match spanning texts is skipped past its first byte.
+    const PrintTableFrozenCells& frozen = *column.frozen;
+    std::vector<bool> textMatches(frozen.offsets.size() - 1, false);
+    const char* blob = frozen.blob.data();
+    size_t position = 0;
+    const char* found;
+    while ((found = PrintTableFind(blob + position, frozen.blob.length() - position, pattern.data(), pattern.length())) != nullptr)
+    {
+        const size_t start = found - blob;
+        const size_t text = std::upper_bound(frozen.offsets.begin(), frozen.offsets.end(), uint32_t(start)) - frozen.offsets.begin() - 1;
+        if (start + pattern.length() <= frozen.offsets[text + 1])
+        {
+            textMatches[text] = true;
+            position = frozen.offsets[text + 1];
+        }
+        else
+        {
+            position = start + 1;
+        }
+    }
+    size_t index = 0;
+    for (size_t r = 0; r < matches.size(); r++)
+    {
+        if (PrintTableIsNull(column, r))
+        {
+            continue;
+        }
+        if (textMatches[frozen.codes.empty() ? index : frozen.codes[index]])
+        {
+            matches[r] = true;
+        }
+        index++;
+    }
+}
+
+PrintTableView PrintTable::Grep(const std::string& pattern, const std::vector<std::string>& searchedColumns, bool highlight) const
+{
+    PrintTableView view = PrintTableSelection(*this);
+    if (highlight && !pattern.empty())
+    {
+        view.highlightPattern = pattern;
+    }
+
+    std::vector<size_t> searchColumns;
+    for (const std::string& column : searchedColumns)
+    {
+        const int index = FindColumn(column);
+        if (index < 0)
+        {
+            printf("Column '%s' does not exist in table '%s'.\n", column.c_str(), title.c_str());
+            return view;
+        }
+        searchColumns.push_back(index);
+    }
+    if (searchColumns.empty())
+    {
+        for (size_t c = 0; c < columnNames.size(); c++)
+        {
+            searchColumns.push_back(c);
+        }
+    }
+
+    // Use the trigram index to narrow down the rows to verify if it covers all the searched columns
+    bool useIndex = trigramIndex.enabled && pattern.length() >= 3;
+    for (const size_t c : searchColumns)
+    {
+        useIndex = useIndex && std::find(trigramIndex.columns.begin(), trigramIndex.columns.end(), c) != trigramIndex.columns.end();
+    }
+    std::vector<uint32_t> candidates;
+    if (useIndex)
+    {
+        if (!trigramIndex.built)
+        {
+            for (size_t r = 0; r < numRows; r++)
+            {
+                PrintTableIndexTrigrams(trigramIndex, *this, r);
+            }
+            trigramIndex.built = true;
+        }
+        candidates = PrintTableTrigramCandidates(trigramIndex, pattern);
+    }
+
+    // Frozen columns are searched in their blobs, so each distinct text of a dictionary encoded column only once
+    if (frozen && !useIndex && !pattern.empty())
+    {
+        std::vector<bool> matches(numRows, false);
+        for (const size_t c : searchColumns)
+        {
+            PrintTableFrozenMatches(columns[c], pattern, matches);
+        }
+        for (size_t r = 0; r < numRows; r++)
+        {
+            if (matches[r])
+            {
+                view.rowSources.push_back(r);
+            }
+        }
+        return view;
+    }
+
+    const size_t numCandidates = useIndex ? candidates.size() : numRows;
+    std::string scratch;
+    for (size_t i = 0; i < numCandidates; i++)
+    {
+        const size_t r = useIndex ? candidates[i] : i;
+        for (const size_t c : searchColumns)
+        {
+            const std::string& cell = PrintTableCellText(columns[c], r, scratch);
+            if (PrintTableFind(cell.data(), cell.length(), pattern.data(), pattern.length()) != nullptr)
+            {
+                view.rowSources.push_back(r);
+                break;
+            }
+        }
+    }
+    return view;
+}
+
+// A token of a query passed to PrintTable::Query
+struct PrintTableQueryToken
+{
+    enum class Kind
+    {
+        Identifier,
+        String,
+        Number,
+        Symbol,
+        End
+    };
+    Kind kind;
+    std::string text;
+    size_t position;
+};
+
+// A node of a parsed where clause. And/Or nodes refer to their operands by index into the node list.
+struct PrintTableQueryNode
+{
+    enum class Kind
+    {
+        Compare,
+        And,
+        Or
+    };
+    Kind kind;
+    size_t left;
+    size_t right;
+    size_t column;
+    std::string op;
+    std::string value;
+    bool numeric;
+    double number;
+};
+
+struct PrintTableQueryParser
+{
+    const PrintTable& table;
+    std::vector<PrintTableQueryToken> tokens;
+    size_t current = 0;
+    std::vector<PrintTableQueryNode> nodes;
+    std::string error;
+
+    PrintTableQueryParser(const PrintTable& table) : table(table) {}
+
+    bool Tokenize(const std::string& query)
+    {
+        size_t i = 0;
+        while (i < query.length())
+        {
+            const char ch = query[i];
+            if (isspace((unsigned char)ch))
+            {
+                i++;
+            }
+            else if (isalpha((unsigned char)ch) || ch == '_')
+            {
+                const size_t start = i;
+                while (i < query.length() && (isalnum((unsigned char)query[i]) || query[i] == '_' || query[i] == '.'))
+                {
+                    i++;
+                }
+                tokens.push_back({ PrintTableQueryToken::Kind::Identifier, query.substr(start, i - start), start });
+            }
+            else if (isdigit((unsigned char)ch) || ((ch == '-' || ch == '.') && i + 1 < query.length() && (isdigit((unsigned char)query[i + 1]) || query[i + 1] == '.')))
+            {
+                const size_t start = i;
+                i++;
+                while (i < query.length() && (isdigit((unsigned char)query[i]) || query[i] == '.' || query[i] == 'e' || query[i] == 'E'))
+                {
+                    i++;
+                }
+                tokens.push_back({ PrintTableQueryToken::Kind::Number, query.substr(start, i - start), start });
+            }
+            else if (ch == '"' || ch == '\'' || ch == '`')
+            {
+                // Backticks quote column names that are not plain identifiers
+                const size_t start = i;
+                const size_t end = query.find(ch, i + 1);
+                if (end == std::string::npos)
+                {
+                    error = "unterminated quote at position " + std::to_string(start);
+                    return false;
+                }
+                const PrintTableQueryToken::Kind kind = ch == '`' ? PrintTableQueryToken::Kind::Identifier : PrintTableQueryToken::Kind::String;
+                tokens.push_back({ kind, query.substr(i + 1, end - i - 1), start });
+                i = end + 1;
+            }
+            else if ((ch == '!' || ch == '<' || ch == '>') && i + 1 < query.length() && query[i + 1] == '=')
+            {
+                tokens.push_back({ PrintTableQueryToken::Kind::Symbol, query.substr(i, 2), i });
+                i += 2;
+            }
+            else if (ch == '<' && i + 1 < query.length() && query[i + 1] == '>')
+            {
+                tokens.push_back({ PrintTableQueryToken::Kind::Symbol, "!=", i });
+                i += 2;
+            }
+            else if (strchr("=<>,()*", ch) != nullptr)
+            {
+                tokens.push_back({ PrintTableQueryToken::Kind::Symbol, std::string(1, ch), i });
+                i++;
+            }
+            else
+            {
+                error = std::string("unexpected character '") + ch + "' at position " + std::to_string(i);
+                return false;
+            }
+        }
+        tokens.push_back({ PrintTableQueryToken::Kind::End, "", query.length() });
+        return true;
+    }
+
+    const PrintTableQueryToken& Peek() const
+    {
+        return tokens[current];
+    }
+
+    bool IsKeyword(const char* keyword) const
+    {
+        const PrintTableQueryToken& token = Peek();
+        if (token.kind != PrintTableQueryToken::Kind::Identifier || token.text.length() != strlen(keyword))
+        {
+            return false;
+        }
+        for (size_t i = 0; i < token.text.length(); i++)
+        {
+            if (tolower((unsigned char)token.text[i]) != keyword[i])
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool ExpectKeyword(const char* keyword)
+    {
+        if (!IsKeyword(keyword))
+        {
+            return Fail(std::string("expected '") + keyword + "'");
+        }
+        current++;
+        return true;
+    }
+
+    bool IsSymbol(const char* symbol) const
+    {
+        return Peek().kind == PrintTableQueryToken::Kind::Symbol && Peek().text == symbol;
+    }
+
+    bool Fail(const std::string& message)
+    {
+        if (error.empty())
+        {
+            error = message + " at position " + std::to_string(Peek().position);
+        }
+        return false;
+    }
+
+    bool ParseColumn(size_t& column)
+    {
+        if (Peek().kind != PrintTableQueryToken::Kind::Identifier)
+        {
+            return Fail("expected a column name");
+        }
+        // Computed columns can be queried too
+        for (size_t c = 0; c < table.NumColumns(); c++)
+        {
+            if (table.ColumnName(c) == Peek().text)
+            {
+                column = c;
+                current++;
+                return true;
+            }
+        }
+        return Fail("unknown column '" + Peek().text + "'");
+    }
+
+    bool ParseComparison(size_t& node)
+    {
+        if (IsSymbol("("))
+        {
+            current++;
+            if (!ParseOr(node))
+            {
+                return false;
+            }
+            if (!IsSymbol(")"))
+            {
+                return Fail("expected ')'");
+            }
+            current++;
+            return true;
+        }
+        PrintTableQueryNode comparison;
+        comparison.kind = PrintTableQueryNode::Kind::Compare;
+        comparison.left = comparison.right = 0;
+        if (!ParseColumn(comparison.column))
+        {
+            return false;
+        }
+        if (!(IsSymbol("=") || IsSymbol("!=") || IsSymbol("<") || IsSymbol("<=") || IsSymbol(">") || IsSymbol(">=")))
+        {
+            return Fail("expected a comparison operator");
+        }
+        comparison.op = Peek().text;
+        current++;
+        if (Peek().kind != PrintTableQueryToken::Kind::String && Peek().kind != PrintTableQueryToken::Kind::Number)
+        {
+            return Fail("expected a string or a number");
+        }
+        comparison.value = Peek().text;
+        comparison.numeric = Peek().kind == PrintTableQueryToken::Kind::Number;
+        comparison.number = comparison.numeric ? strtod(comparison.value.c_str(), nullptr) : 0.0;
+        current++;
+        node = nodes.size();
+        nodes.push_back(comparison);
+        return true;
+    }
+
+    bool ParseAnd(size_t& node)
+    {
+        if (!ParseComparison(node))
+        {
+            return false;
+        }
+        while (IsKeyword("and"))
+        {
+            current++;
+            size_t right;
+            if (!ParseComparison(right))
+            {
+                return false;
+            }
+            nodes.push_back({ PrintTableQueryNode::Kind::And, node, right, 0, "", "", false, 0.0 });
+            node = nodes.size() - 1;
+        }
+        return true;
+    }
+
+    bool ParseOr(size_t& node)
+    {
+        if (!ParseAnd(node))
+        {
+            return false;
+        }
+        while (IsKeyword("or"))
+        {
+            current++;
+            size_t right;
+            if (!ParseAnd(right))
+            {
+                return false;
+            }
+            nodes.push_back({ PrintTableQueryNode::Kind::Or, node, right, 0, "", "", false, 0.0 });
+            node = nodes.size() - 1;
+        }
+        return true;
+    }
+};
+
+// Narrows the selection in to the rows for which the where clause node holds.
+// Every comparison is a tight loop over one column for all selected rows, and And nodes pass
+// the output of their left operand as the input to their right operand.
+static void PrintTableQueryFilter(const PrintTable& table, const std::vector<PrintTableQueryNode>& nodes, size_t node, const std::vector<size_t>& in, std::vector<size_t>& out)
+{
+    const PrintTableQueryNode& n = nodes[node];
+    out.clear();
+    if (n.kind == PrintTableQueryNode::Kind::And)
+    {
+        std::vector<size_t> left;
+        PrintTableQueryFilter(table, nodes, n.left, in, left);
+        PrintTableQueryFilter(table, nodes, n.right, left, out);
+        return;
+    }
+    if (n.kind == PrintTableQueryNode::Kind::Or)
+    {
+        std::vector<size_t> left;
+        std::vector<size_t> right;
+        PrintTableQueryFilter(table, nodes, n.left, in, left);
+        PrintTableQueryFilter(table, nodes, n.right, in, right);
+        std::set_union(left.begin(), left.end(), right.begin(), right.end(), std::back_inserter(out));
+        return;
+    }
+
+    // Only the selected rows are read. Stored columns are read in place, typed ones straight from their numbers,
+    // and computed columns are formatted a row at a time.
+    const PrintTableColumn* column = n.column < table.columns.size() ? &table.columns[n.column] : nullptr;
+    const int op = n.op == "=" ? 0 : n.op == "!=" ? 1 : n.op == "<" ? 2 : n.op == "<=" ? 3 : n.op == ">" ? 4 : 5;
+    std::string scratch;
+    out.reserve(in.size());
+    for (const size_t r : in)
+    {
+        // Like in SQL, nulls never satisfy a comparison
+        if (column != nullptr && PrintTableIsNull(*column, r))
+        {
+            continue;
+        }
+        const std::string* cell = nullptr;
+        if (column == nullptr)
+        {
+            scratch = table.Cell(r, n.column);
+            cell = &scratch;
+        }
+        else if (!n.numeric)
+        {
+            cell = &PrintTableCellText(*column, r, scratch);
+        }
+        int order;
+        if (n.numeric)
+        {
+            // Cells that are not numbers never satisfy a numeric comparison
+            double number;
+            if (column != nullptr ? !PrintTableCellNumber(*column, r, number) : !PrintTableParseNumber(*cell, number))
+            {
+                continue;
+            }
+            order = number < n.number ? -1 : number > n.number ? 1 : 0;
+        }
+        else
+        {
+            order = cell->compare(n.value);
+        }
+        const bool keep = op == 0 ? order == 0 : op == 1 ? order != 0 : op == 2 ? order < 0 : op == 3 ? order <= 0 : op == 4 ? order > 0 : order >= 0;
+        if (keep)
+        {
+            out.push_back(r);
+        }
+    }
+}
+
+PrintTableView PrintTable::Query(const std::string& query, std::string* error) const
+{
+    PrintTableView view;
+    PrintTableQueryParser parser(*this);
+    std::vector<size_t> projection;
+    bool hasWhere = false;
+    size_t where = 0;
+    bool hasOrder = false;
+    size_t orderColumn = 0;
+    bool descending = false;
+    size_t limit = PRINT_TABLE_NO_ROW;
+
+    bool parsed = parser.Tokenize(query) && parser.ExpectKeyword("select");
+    if (parsed && parser.IsSymbol("*"))
+    {
+        parser.current++;
+        for (size_t c = 0; c < NumColumns(); c++)
+        {
+            projection.push_back(c);
+        }
+    }
+    else
+    {
+        while (parsed)
+        {
+            size_t column;
+            parsed = parser.ParseColumn(column);
+            projection.push_back(column);
+            if (!parser.IsSymbol(","))
+            {
+                break;
+            }
+            parser.current++;
+        }
+    }
+    if (parsed && parser.IsKeyword("where"))
+    {
+        parser.current++;
+        hasWhere = true;
+        parsed = parser.ParseOr(where);
+    }
+    if (parsed && parser.IsKeyword("order"))
+    {
+        parser.current++;
+        hasOrder = true;
+        parsed = parser.ExpectKeyword("by") && parser.ParseColumn(orderColumn);
+        if (parsed && (parser.IsKeyword("asc") || parser.IsKeyword("desc")))
+        {
+            descending = parser.IsKeyword("desc");
+            parser.current++;
+        }
+    }
+    if (parsed && parser.IsKeyword("limit"))
+    {
+        parser.current++;
+        if (parser.Peek().kind != PrintTableQueryToken::Kind::Number || parser.Peek().text.find_first_not_of("0123456789") != std::string::npos)
+        {
+            parsed = parser.Fail("expected a row count");
+        }
+        else
+        {
+            limit = strtoul(parser.Peek().text.c_str(), nullptr, 10);
+            parser.current++;
+        }
+    }
+    if (parsed && parser.Peek().kind != PrintTableQueryToken::Kind::End)
+    {
+        parsed = parser.Fail("unexpected '" + parser.Peek().text + "'");
+    }
+    if (!parsed)
+    {
+        const std::string message = "Invalid query on table '" + title + "': " + parser.error + ".\n";
+        if (error != nullptr)
+        {
+            *error = message;
+        }
+        else
+        {
+            printf("%s", message.c_str());
+        }
+        return view;
+    }
+
+    view.title = title;
+    view.tables = { this };
+    for (const size_t column : projection)
+    {
+        view.columnNames.push_back(ColumnName(column));
+        view.columnTables.push_back(0);
+        view.columnSources.push_back(column);
+    }
+
+    // Filter
+    std::vector<size_t> selection(numRows);
+    for (size_t r = 0; r < numRows; r++)
+    {
+        selection[r] = r;
+    }
+    if (hasWhere)
+    {
+        std::vector<size_t> filtered;
+        PrintTableQueryFilter(*this, parser.nodes, where, selection, filtered);
+        selection.swap(filtered);
+    }
+
+    // Sort, only as far as needed for the limit. The column is sorted numerically if all the selected cells are numbers.
+    if (hasOrder)
+    {
+        const bool typed = orderColumn < columns.size() && columns[orderColumn].typedStorage;
+        PrintTableCowVector<std::string> computedCells;
+        const PrintTableCowVector<std::string>& cells = typed ? computedCells : PrintTableColumnCells(*this, orderColumn, computedCells);
+        std::vector<double> numbers(numRows);
+        std::vector<char> last(numRows, 0);
+        bool numeric = true;
+        for (const size_t r : selection)
+        {
+            if (IsNull(r, orderColumn))
+            {
+                last[r] = 1;
+                continue;
+            }
+            numeric = numeric && (typed ? PrintTableCellNumber(columns[orderColumn], r, numbers[r]) : PrintTableParseNumber(cells[r], numbers[r]));
+        }
+        // NaN is unordered, so it sorts with the nulls to keep the comparison a strict weak ordering
+        for (size_t i = 0; i < selection.size() && numeric; i++)
+        {
+            last[selection[i]] = last[selection[i]] || std::isnan(numbers[selection[i]]);
+        }
+        // Nulls come last in either direction. Ties are broken by row index to make the order deterministic.
+        const auto compare = [&](size_t a, size_t b)
+        {
+            const bool lastA = last[a] != 0;
+            const bool lastB = last[b] != 0;
+            if (lastA != lastB)
+            {
+                return lastB;
+            }
+            int order = lastA ? 0 : numeric ? (numbers[a] < numbers[b] ? -1 : numbers[a] > numbers[b] ? 1 : 0) : cells[a].compare(cells[b]);
+            order = descending ? -order : order;
+            return order != 0 ? order < 0 : a < b;
+        };
+        if (limit < selection.size())
+        {
+            std::partial_sort(selection.begin(), selection.begin() + limit, selection.end(), compare);
+        }
+        else
+        {
+            std::sort(selection.begin(), selection.end(), compare);
+        }
+    }
+
+    // Limit
+    if (limit < selection.size())
+    {
+        selection.resize(limit);
+    }
+    view.rowSources.swap(selection);
+    return view;
+}
+
+// Builds the join key of a row into key, each cell prefixed with its length so no cell content can make two keys
+// collide. Returns false if a key cell is null: like in SQL, nulls never match.
+static bool PrintTableRowKey(const PrintTable& table, size_t row, const std::vector<int>& keyColumns, std::string& key)
+{
+    key.clear();
+    for (const int column : keyColumns)
+    {
+        if (table.IsNull(row, column))
+        {
+            return false;
+        }
+        const std::string cell = table.Cell(row, column);
+        const size_t length = cell.length();
+        key.append((const char*)&length, sizeof(length));
+        key += cell;
+    }
+    return true;
+}
+
+PrintTableView PrintTable::Join(const PrintTable& left, const PrintTable& right, const std::vector<std::string>& keyColumns, PrintTableJoinKind kind)
+{
+    PrintTableView view;
+    view.title = left.title + " / " + right.title;
+    view.tables = { &left, &right };
+
+    std::vector<int> leftKeys;
+    std::vector<int> rightKeys;
+    for (const std::string& keyColumn : keyColumns)
+    {
+        leftKeys.push_back(left.FindColumn(keyColumn));
+        rightKeys.push_back(right.FindColumn(keyColumn));
+        if (leftKeys.back() < 0 || rightKeys.back() < 0)
+        {
+            printf("Key column '%s' must exist in both table '%s' and table '%s' to join them.\n", keyColumn.c_str(), left.title.c_str(), right.title.c_str());
+            return view;
+        }
+    }
+
+    // All columns of the left table followed by the non-key columns of the right table
+    for (size_t c = 0; c < left.columnNames.size(); c++)
+    {
+        view.columnNames.push_back(left.columnNames[c]);
+        view.columnTables.push_back(0);
+        view.columnSources.push_back(c);
+    }
+    for (size_t c = 0; c < right.columnNames.size(); c++)
+    {
+        if (std::find(rightKeys.begin(), rightKeys.end(), int(c)) == rightKeys.end())
+        {
+            view.columnNames.push_back(right.columnNames[c]);
+            view.columnTables.push_back(1);
+            view.columnSources.push_back(c);
+        }
+    }
+
+    // Build the hash index on the smaller table and probe it with the rows of the larger one
+    const bool buildLeft = left.NumRows() < right.NumRows();
+    const PrintTable& buildTable = buildLeft ? left : right;
+    const PrintTable& probeTable = buildLeft ? right : left;
+    const std::vector<int>& buildKeys = buildLeft ? leftKeys : rightKeys;
+    const std::vector<int>& probeKeys = buildLeft ? rightKeys : leftKeys;
+    std::unordered_map<std::string, std::vector<size_t>> index;
+    index.reserve(buildTable.NumRows());
+    std::string key;
+    for (size_t r = 0; r < buildTable.NumRows(); r++)
+    {
+        if (PrintTableRowKey(buildTable, r, buildKeys, key))
+        {
+            index[key].push_back(r);
+        }
+    }
+
+    // Pairs of (left row, right row)
+    std::vector<std::pair<size_t, size_t>> matches;
+    std::vector<bool> leftMatched(left.NumRows(), false);
+    for (size_t r = 0; r < probeTable.NumRows(); r++)
+    {
+        if (!PrintTableRowKey(probeTable, r, probeKeys, key))
+        {
+            continue;
+        }
+        const auto it = index.find(key);
+        if (it == index.end())
+        {
+            continue;
+        }
+        for (const size_t match : it->second)
+        {
+            const size_t leftRow = buildLeft ? match : r;
+            matches.push_back({ leftRow, buildLeft ? r : match });
+            leftMatched[leftRow] = true;
+        }
+    }
+    if (kind == PrintTableJoinKind::Left)
+    {
+        for (size_t r = 0; r < left.NumRows(); r++)
+        {
+            if (!leftMatched[r])
+            {
+                matches.push_back({ r, PRINT_TABLE_NO_ROW });
+            }
+        }
+    }
+    // Keep the rows in the order of the left table regardless of which side was probed
+    std::sort(matches.begin(), matches.end());
+
+    view.rowSources.reserve(matches.size() * 2);
+    for (const std::pair<size_t, size_t>& match : matches)
+    {
+        view.rowSources.push_back(match.first);
+        view.rowSources.push_back(match.second);
+    }
+    return view;
+}
+
+// Hashes the key of a row as built by PrintTableRowKey, which also decides whether two keys are equal.
+// Returns false for a key with a null cell, which matches no other key.
+static bool PrintTableKeyHash(const PrintTable& table, size_t row, const std::vector<int>& keyColumns, std::string& key, uint64_t& hash)
+{
+    if (!PrintTableRowKey(table, row, keyColumns, key))
+    {
+        return false;
+    }
+    hash = PrintTableHash(key.data(), key.length(), 0);
+    return true;
+}
+
+PrintTable PrintTable::Diff(const PrintTable& previous, const PrintTable& current, const std::vector<std::string>& keyColumns)
+{
+    PrintTable diff;
+    diff.SetTitle("Changes in " + current.title);
+    if (previous.columnNames != current.columnNames)
+    {
+        printf("Table '%s' and table '%s' must have the same columns to be diffed.\n", previous.title.c_str(), current.title.c_str());
+        return diff;
+    }
+    std::vector<int> keys;
+    for (const std::string& keyColumn : keyColumns)
+    {
+        keys.push_back(current.FindColumn(keyColumn));
+        if (keys.back() < 0)
+        {
+            printf("Key column '%s' does not exist in table '%s'.\n", keyColumn.c_str(), current.title.c_str());
+            return diff;
+        }
+    }
+    diff.AddColumn("");
+    for (const std::string& columnName : current.columnNames)
+    {
+        diff.AddColumn(columnName);
+    }
+
+    // Index the previous rows by the hash of their key in an open addressing table.
+    // Collisions are resolved by comparing the key cells.
+    size_t capacity = 16;
+    while (capacity < previous.NumRows() * 2)
+    {
+        capacity *= 2;
+    }
+    // The hash and row of a slot are stored together so a probe touches a single cache line.
+    std::vector<std::pair<uint64_t, size_t>> slots(capacity, { 0, PRINT_TABLE_NO_ROW });
+    std::string key;
+    std::string previousKey;
+    uint64_t hash = 0;
+    for (size_t r = 0; r < previous.NumRows(); r++)
+    {
+        // Rows with a null key are never matched, so they are left out
+        if (!PrintTableKeyHash(previous, r, keys, key, hash))
+        {
+            continue;
+        }
+        size_t slot = hash & (capacity - 1);
+        while (slots[slot].second != PRINT_TABLE_NO_ROW)
+        {
+            slot = (slot + 1) & (capacity - 1);
+        }
+        slots[slot] = { hash, r };
+    }
+
+    std::vector<bool> previousMatched(previous.NumRows(), false);
+    std::vector<std::string> diffRow(current.columnNames.size() + 1);
+    for (size_t r = 0; r < current.NumRows(); r++)
+    {
+        size_t previousRow = PRINT_TABLE_NO_ROW;
+        const bool hasKey = PrintTableKeyHash(current, r, keys, key, hash);
+        for (size_t slot = hash & (capacity - 1); hasKey && slots[slot].second != PRINT_TABLE_NO_ROW; slot = (slot + 1) & (capacity - 1))
+        {
+            if (slots[slot].first == hash && PrintTableRowKey(previous, slots[slot].second, keys, previousKey) && previousKey == key)
+            {
+                previousRow = slots[slot].second;
+                break;
+            }
+        }
+        if (previousRow == PRINT_TABLE_NO_ROW)
+        {
+            diffRow[0] = "+";
+            for (size_t c = 0; c < current.columns.size(); c++)
+            {
+                diffRow[c + 1] = current.Cell(r, c);
+            }
+            diff.AddRow(diffRow);
+            continue;
+        }
+        previousMatched[previousRow] = true;
+        // Equal fingerprints means equal rows, so only rows that actually changed are compared cell by cell
+        if (previous.rowFingerprints[previousRow] == current.rowFingerprints[r])
+        {
+            continue;
+        }
+        diffRow[0] = "~";
+        for (size_t c = 0; c < current.columnNames.size(); c++)
+        {
+            const std::string before = previous.Cell(previousRow, c);
+            const std::string after = current.Cell(r, c);
+            if (before != after)
+            {
+                diffRow[c + 1] = before + " -> " + after;
+            }
+            else if (std::find(keys.begin(), keys.end(), int(c)) != keys.end())
+            {
+                diffRow[c + 1] = after;
+            }
+            else
+            {
+                diffRow[c + 1] = "";
+            }
+        }
+        diff.AddRow(diffRow);
+    }
+    for (size_t r = 0; r < previous.NumRows(); r++)
+    {
+        if (!previousMatched[r])
+        {
+            diffRow[0] = "-";
+            for (size_t c = 0; c < previous.columns.size(); c++)
+            {
+                diffRow[c + 1] = previous.Cell(r, c);
+            }
+            diff.AddRow(diffRow);
+        }
+    }
+    return diff;
+}
+
+PrintTable PrintTable::Pivot(const PrintTable& source, const std::string& rowKey, const std::string& columnKey, const std::string& valueColumn, PrintTableAggregate aggregate)
+{
+    PrintTable pivot;
+    pivot.SetTitle(source.title);
+    const int rowKeyColumn = source.FindColumn(rowKey);
+    const int columnKeyColumn = source.FindColumn(columnKey);
+    const int valueIndex = source.FindColumn(valueColumn);
+    if (rowKeyColumn < 0 || columnKeyColumn < 0 || valueIndex < 0)
+    {
+        printf("Columns '%s', '%s' and '%s' must all exist in table '%s' to pivot it.\n", rowKey.c_str(), columnKey.c_str(), valueColumn.c_str(), source.title.c_str());
+        return pivot;
+    }
+
+    struct Accumulator
+    {
+        double value;
+        size_t count;
+    };
+    PrintTableCowVector<std::string> rowKeyScratch;
+    PrintTableCowVector<std::string> columnKeyScratch;
+    const PrintTableCowVector<std::string>& rowKeys = PrintTableColumnCells(source, rowKeyColumn, rowKeyScratch);
+    const PrintTableCowVector<std::string>& columnKeys = PrintTableColumnCells(source, columnKeyColumn, columnKeyScratch);
+
+    // Single hash aggregation pass. Row and column keys get dense ids in order of first appearance
+    // and each (row id, column id) pair is one entry in a flat accumulator map.
+    std::unordered_map<std::string, uint32_t> rowIds;
+    std::unordered_map<std::string, uint32_t> columnIds;
+    std::vector<const std::string*> distinctRows;
+    std::vector<const std::string*> distinctColumns;
+    std::unordered_map<uint64_t, Accumulator> accumulators;
+    accumulators.reserve(source.numRows);
+    for (size_t r = 0; r < source.numRows; r++)
+    {
+        // A null key is no key, rather than a row or column named after the null text
+        if (PrintTableIsNull(source.columns[rowKeyColumn], r) || PrintTableIsNull(source.columns[columnKeyColumn], r))
+        {
+            continue;
+        }
+        const auto rowId = rowIds.insert({ rowKeys[r], uint32_t(distinctRows.size()) });
+        if (rowId.second)
+        {
+            distinctRows.push_back(&rowKeys[r]);
+        }
+        const auto columnId = columnIds.insert({ columnKeys[r], uint32_t(distinctColumns.size()) });
+        if (columnId.second)
+        {
+            distinctColumns.push_back(&columnKeys[r]);
+        }
+        // Null values are not aggregated, not even counted
+        double value = 0.0;
+        if (PrintTableIsNull(source.columns[valueIndex], r) || (aggregate != PrintTableAggregate::Count && !PrintTableCellNumber(source.columns[valueIndex], r, value)))
+        {
+            continue;
+        }
+        const uint64_t key = uint64_t(rowId.first->second) << 32 | columnId.first->second;
+        const auto accumulator = accumulators.insert({ key, { value, 0 } });
+        Accumulator& acc = accumulator.first->second;
+        if (!accumulator.second)
+        {
+            switch (aggregate)
+            {
+            case PrintTableAggregate::Sum:
+            case PrintTableAggregate::Average:
+                acc.value += value;
+                break;
+            case PrintTableAggregate::Min:
+                acc.value = std::min(acc.value, value);
+                break;
+            case PrintTableAggregate::Max:
+                acc.value = std::max(acc.value, value);
+                break;
+            case PrintTableAggregate::Count:
+                break;
+            }
+        }
+        acc.count++;
+    }
+
+    // The discovered columns are sorted, the rows keep the order in which their keys first appeared
+    std::vector<uint32_t> columnOrder(distinctColumns.size());
+    for (size_t c = 0; c < columnOrder.size(); c++)
+    {
+        columnOrder[c] = c;
+    }
+    std::sort(columnOrder.begin(), columnOrder.end(), [&](uint32_t a, uint32_t b) { return *distinctColumns[a] < *distinctColumns[b]; });
+    std::vector<uint32_t> columnPositions(distinctColumns.size());
+    pivot.AddColumn(rowKey);
+    for (size_t c = 0; c < columnOrder.size(); c++)
+    {
+        columnPositions[columnOrder[c]] = c + 1;
+        pivot.AddColumn(*distinctColumns[columnOrder[c]]);
+    }
+
+    // Append the rows in order, visiting the accumulators sorted by (row id, column id).
+    // Pairs that never had a value are null.
+    std::vector<std::pair<uint64_t, Accumulator>> entries(accumulators.begin(), accumulators.end());
+    std::sort(entries.begin(), entries.end(), [](const std::pair<uint64_t, Accumulator>& a, const std::pair<uint64_t, Accumulator>& b) { return a.first < b.first; });
+    std::vector<const Accumulator*> rowValues(distinctColumns.size());
+    size_t e = 0;
+    for (size_t r = 0; r < distinctRows.size(); r++)
+    {
+        std::fill(rowValues.begin(), rowValues.end(), nullptr);
+        for (; e < entries.size() && (entries[e].first >> 32) == r; e++)
+        {
+            rowValues[columnPositions[entries[e].first & 0xffffffff] - 1] = &entries[e].second;
+        }
+        PrintTableAppendToColumn(pivot.columns[0], *distinctRows[r]);
+        for (size_t c = 0; c < rowValues.size(); c++)
+        {
+            const Accumulator* acc = rowValues[c];
+            if (acc == nullptr)
+            {
+                PrintTableAppendValidity(pivot.columns[c + 1], false);
+                continue;
+            }
+            double value = acc->value;
+            if (aggregate == PrintTableAggregate::Count)
+            {
+                value = acc->count;
+            }
+            else if (aggregate == PrintTableAggregate::Average)
+            {
+                value /= acc->count;
+            }
+            PrintTableAppendToColumn(pivot.columns[c + 1], PrintTableFormatNumber(value));
+        }
+        pivot.AppendRowMetadata(pivot.numRows++);
+    }
+    // The aggregates are numbers, so the value columns come out typed like those of a table filled by AddRows
+    pivot.InferColumnTypes();
+    pivot.startedAddingRows = true;
+    pivot.alteredState = true;
+    return pivot;
+}
+
+// Reads the stored number of a cell of a typed column. Returns false if the cell is only held as text,
+// i.e. it is in a chunk that was sealed before the column was typed.
+static bool PrintTableStoredNumber(const PrintTableColumn& column, size_t row, int64_t& number)
+{
+    if (row < column.sealedRows)
+    {
+        const PrintTableSealedChunk& chunk = column.sealedChunks[row / PRINT_TABLE_CHUNK_ROWS];
+        if (!chunk.typed || chunk.scale != column.scale)
+        {
+            return false;
+        }
+        memcpy(&number, PrintTableSealedData(column, row / PRINT_TABLE_CHUNK_ROWS) + row % PRINT_TABLE_CHUNK_ROWS * sizeof(int64_t), sizeof(number));
+        return true;
+    }
+    number = column.numbers[PrintTableValueIndex(column, row)];
+    return true;
+}
+
+// Marks the start of the binary form written by PrintTable::Serialize
+static const char PRINT_TABLE_WIRE_MAGIC[4] = { 'P', 'T', 'W', '1' };
+
+/*
+The binary form of a table is
+    magic, title, null text, number of columns, number of rows
+    per column: name, type, whether it is stored as numbers, scale, fraction digits, UTC offset, max cell width
+    per column: number of nulls, a validity bit per row if there are any, then the cells that are not null,
+                each as an 8 byte number or as its length followed by its text
+with all counts, lengths and small numbers written as varints.
+*/
+void PrintTable::Serialize(std::string& output) const
+{
+    output.append(PRINT_TABLE_WIRE_MAGIC, sizeof(PRINT_TABLE_WIRE_MAGIC));
+    PrintTableAppendVarint(output, title.length());
+    output += title;
+    PrintTableAppendVarint(output, nullText.length());
+    output += nullText;
+    PrintTableAppendVarint(output, columns.size());
+    PrintTableAppendVarint(output, numRows);
+    std::string scratch;
+    std::vector<bool> typed(columns.size());
+    for (size_t c = 0; c < columns.size(); c++)
+    {
+        const PrintTableColumn& column = columns[c];
+        // Cells sealed before the column was typed are sent as text
+        typed[c] = column.typedStorage;
+        for (const PrintTableSealedChunk& chunk : column.sealedChunks)
+        {
+            typed[c] = typed[c] && chunk.typed && chunk.scale == column.scale;
+        }
+        // Chunks whose widths are stale are measured, the others are summarized already
+        int maxCellWidth = 0;
+        for (size_t i = 0; i < chunks.size(); i++)
+        {
+            if (!chunks[i].widthsDirty)
+            {
+                maxCellWidth = std::max(maxCellWidth, chunks[i].maxCellWidths[c]);
+                continue;
+            }
+            for (size_t r = i * PRINT_TABLE_CHUNK_ROWS; r < std::min(numRows, (i + 1) * PRINT_TABLE_CHUNK_ROWS); r++)
+            {
+                maxCellWidth = PrintTableIsNull(column, r) ? maxCellWidth : std::max(maxCellWidth, int(PrintTableCellText(column, r, scratch).length()));
+            }
+        }
+        PrintTableAppendVarint(output, columnNames[c].length());
+        output += columnNames[c];
+        output += char(column.type);
+        output += char(typed[c]);
+        PrintTableAppendVarint(output, column.scale);
+        PrintTableAppendVarint(output, column.fractionDigits);
+        PrintTableAppendVarint(output, uint64_t(column.utcOffset));
+        PrintTableAppendVarint(output, maxCellWidth);
+    }
+    for (size_t c = 0; c < columns.size(); c++)
+    {
+        const PrintTableColumn& column = columns[c];
+        PrintTableAppendVarint(output, column.nullCount);
+        if (column.nullCount > 0)
+        {
+            std::string validity((numRows + 7) / 8, '\0');
+            for (size_t r = 0; r < numRows; r++)
+            {
+                validity[r / 8] |= PrintTableIsNull(column, r) ? 0 : char(1 << (r % 8));
+            }
+            output += validity;
+        }
+        for (size_t r = 0; r < numRows; r++)
+        {
+            int64_t number;
+            if (PrintTableIsNull(column, r))
+            {
+                continue;
+            }
+            if (typed[c] && PrintTableStoredNumber(column, r, number))
+            {
+                output.append((const char*)&number, sizeof(number));
+                continue;
+            }
+            const std::string& cell = PrintTableCellText(column, r, scratch);
+            PrintTableAppendVarint(output, cell.length());
+            output += cell;
+        }
+    }
+}
+
+// Bounds checked reading of the binary form written by PrintTable::Serialize
+struct PrintTableWireReader
+{
+    const unsigned char* data;
+    const unsigned char* end;
+    bool failed = false;
+
+    uint64_t Varint()
+    {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            if (data == end)
+            {
+                break;
+            }
+            const unsigned char byte = *data++;
+            value |= uint64_t(byte & 127) << shift;
+            if (byte < 128)
+            {
+                return value;
+            }
+        }
+        failed = true;
+        return 0;
+    }
+
+    // Returns nullptr if fewer than length bytes are left
+    const char* Bytes(size_t length)
+    {
+        if (failed || size_t(end - data) < length)
+        {
+            failed = true;
+            return nullptr;
+        }
+        const char* bytes = (const char*)data;
+        data += length;
+        return bytes;
+    }
+
+    std::string String()
+    {
+        const size_t length = Varint();
+        const char* bytes = Bytes(length);
+        return bytes == nullptr ? std::string() : std::string(bytes, length);
+    }
+};
+
+// A partial table in its binary form, with the cells of each column located but not copied
+struct PrintTableWirePart
+{
+    struct Column
+    {
+        std::string name;
+        PrintTableColumnType type;
+        bool typed;
+        int scale;
+        int fractionDigits;
+        int64_t utcOffset;
+        int maxCellWidth;
+        const char* validity = nullptr; // A bit per row, nullptr if there are no nulls
+        std::vector<const char*> values; // Per cell that is not null, its 8 byte number or its text
+        std::vector<uint32_t> lengths;   // Per cell that is not null, the length of its text
+        size_t nextValue = 0;            // Index into values of the next row to be merged
+    };
+    std::string title;
+    std::string nullText;
+    size_t numRows = 0;
+    size_t nextRow = 0;
+    std::vector<Column> columns;
+
+    bool IsNull(size_t column, size_t row) const
+    {
+        return columns[column].validity != nullptr && !(columns[column].validity[row / 8] >> (row % 8) & 1);
+    }
+};
+
+static bool PrintTableReadWirePart(const std::string& bytes, PrintTableWirePart& part)
+{
+    PrintTableWireReader reader;
+    reader.data = (const unsigned char*)bytes.data();
+    reader.end = reader.data + bytes.length();
+    const char* magic = reader.Bytes(sizeof(PRINT_TABLE_WIRE_MAGIC));
+    if (magic == nullptr || memcmp(magic, PRINT_TABLE_WIRE_MAGIC, sizeof(PRINT_TABLE_WIRE_MAGIC)) != 0)
+    {
+        return false;
+    }
+    part.title = reader.String();
+    part.nullText = reader.String();
+    const size_t numColumns = reader.Varint();
+    part.numRows = reader.Varint();
+    if (reader.failed || numColumns > bytes.length() || part.numRows / 8 > bytes.length())
+    {
+        return false;
+    }
+    part.columns.resize(numColumns);
+    for (PrintTableWirePart::Column& column : part.columns)
+    {
+        column.name = reader.String();
+        const char* flags = reader.Bytes(2);
+        column.type = flags == nullptr ? PrintTableColumnType::Text : PrintTableColumnType((unsigned char)flags[0]);
+        column.typed = flags != nullptr && flags[1] != 0;
+        column.scale = int(reader.Varint());
+        column.fractionDigits = int(reader.Varint());
+        column.utcOffset = int64_t(reader.Varint());
+        column.maxCellWidth = int(reader.Varint());
+        if (column.type > PrintTableColumnType::Duration || column.scale > 18 || column.fractionDigits > 9)
+        {
+            return false;
+        }
+    }
+    for (PrintTableWirePart::Column& column : part.columns)
+    {
+        const size_t nullCount = reader.Varint();
+        if (nullCount > 0)
+        {
+            column.validity = reader.Bytes((part.numRows + 7) / 8);
+        }
+        if (reader.failed || nullCount > part.numRows)
+        {
+            return false;
+        }
+        // Values are read for the rows whose validity bit is set, so the bits must agree with the null count
+        if (column.validity != nullptr)
+        {
+            size_t validCount = 0;
+            for (size_t i = 0; i < part.numRows / 8; i++)
+            {
+                validCount += PrintTablePopCount((unsigned char)column.validity[i]);
+            }
+            if (part.numRows % 8 != 0)
+            {
+                validCount += PrintTablePopCount((unsigned char)column.validity[part.numRows / 8] & ((1u << part.numRows % 8) - 1));
+            }
+            if (part.numRows - validCount != nullCount)
+            {
+                return false;
+            }
+        }
+        column.values.resize(part.numRows - nullCount);
+        column.lengths.resize(column.values.size(), sizeof(int64_t));
+        for (size_t v = 0; v < column.values.size() && !reader.failed; v++)
+        {
+            if (!column.typed)
+            {
+                column.lengths[v] = uint32_t(reader.Varint());
+            }
+            column.values[v] = reader.Bytes(column.lengths[v]);
+        }
+    }
+    return !reader.failed;
+}
+
+// Orders the current rows of two parts by a key column, numerically if both store it as numbers of the same scale and
+// like order by otherwise. Null keys come last.
+static bool PrintTableWireKeyLess(const PrintTableWirePart& a, const PrintTableWirePart& b, size_t key)
+{
+    const bool nullA = a.IsNull(key, a.nextRow);
+    const bool nullB = b.IsNull(key, b.nextRow);
+    if (nullA || nullB)
+    {
+        return !nullA;
+    }
+    const PrintTableWirePart::Column& columnA = a.columns[key];
+    const PrintTableWirePart::Column& columnB = b.columns[key];
+    const char* valueA = columnA.values[columnA.nextValue];
+    const char* valueB = columnB.values[columnB.nextValue];
+    if (columnA.typed && columnB.typed && columnA.scale == columnB.scale)
+    {
+        int64_t numberA;
+        int64_t numberB;
+        memcpy(&numberA, valueA, sizeof(numberA));
+        memcpy(&numberB, valueB, sizeof(numberB));
+        return numberA < numberB;
+    }
+    std::string textA;
+    std::string textB;
+    if (columnA.typed)
+    {
+        int64_t number;
+        memcpy(&number, valueA, sizeof(number));
+        textA = PrintTableFormatScaled(number, columnA.scale);
+    }
+    else
+    {
+        textA.assign(valueA, columnA.lengths[columnA.nextValue]);
+    }
+    if (columnB.typed)
+    {
+        int64_t number;
+        memcpy(&number, valueB, sizeof(number));
+        textB = PrintTableFormatScaled(number, columnB.scale);
+    }
+    else
+    {
+        textB.assign(valueB, columnB.lengths[columnB.nextValue]);
+    }
+    return PrintTableCompareKeys(textA, textB) < 0;
+}
+
+PrintTable PrintTable::Merge(const std::vector<std::string>& parts, const std::string& keyColumn)
+{
+    PrintTable merged;
+    std::vector<PrintTableWirePart> wireParts;
+    wireParts.reserve(parts.size());
+    for (size_t p = 0; p < parts.size(); p++)
+    {
+        PrintTableWirePart part;
+        bool matches = PrintTableReadWirePart(parts[p], part);
+        for (size_t c = 0; matches && !wireParts.empty() && c < part.columns.size(); c++)
+        {
+            matches = part.columns[c].name == wireParts[0].columns[c].name && part.columns[c].type == wireParts[0].columns[c].type;
+        }
+        if (!matches || (!wireParts.empty() && part.columns.size() != wireParts[0].columns.size()))
+        {
+            printf("Part %lu cannot be merged: it is cut short or does not have the columns of the first part.\n", p);
+            continue;
+        }
+        wireParts.push_back(part);
+    }
+    if (wireParts.empty())
+    {
+        return merged;
+    }
+
+    // The merged table takes the title, columns and types of the first part
+    const PrintTableWirePart& first = wireParts[0];
+    merged.SetTitle(first.title);
+    merged.SetNullText(first.nullText);
+    for (const PrintTableWirePart::Column& wireColumn : first.columns)
+    {
+        merged.AddColumn(wireColumn.name);
+        PrintTableColumn& column = merged.columns.back();
+        column.type = wireColumn.type;
+        column.typedStorage = wireColumn.typed;
+        column.scale = wireColumn.scale;
+        column.fractionDigits = wireColumn.fractionDigits;
+        column.utcOffset = wireColumn.utcOffset;
+    }
+    merged.typesInferred = true;
+    merged.startedAddingRows = true;
+    const int key = keyColumn.empty() ? -1 : merged.FindColumn(keyColumn);
+    if (!keyColumn.empty() && key < 0)
+    {
+        printf("Parts cannot be merged by column '%s' as they have no such column.\n", keyColumn.c_str());
+        return merged;
+    }
+
+    // Parts are consumed in order when concatenating, otherwise a heap keeps the part with the least key on top.
+    // Ties go to the earlier part so merging is stable.
+    std::vector<size_t> heap;
+    const auto greater = [&](size_t a, size_t b)
+    {
+        if (PrintTableWireKeyLess(wireParts[b], wireParts[a], key))
+        {
+            return true;
+        }
+        return !PrintTableWireKeyLess(wireParts[a], wireParts[b], key) && a > b;
+    };
+    size_t nextPart = 0;
+    for (size_t p = 0; p < wireParts.size() && key >= 0; p++)
+    {
+        if (wireParts[p].numRows > 0)
+        {
+            heap.push_back(p);
+        }
+    }
+    std::make_heap(heap.begin(), heap.end(), greater);
+    std::string text;
+    merged.restoringWidths = true;
+    while (true)
+    {
+        size_t p;
+        if (key >= 0)
+        {
+            if (heap.empty())
+            {
+                break;
+            }
+            std::pop_heap(heap.begin(), heap.end(), greater);
+            p = heap.back();
+            heap.pop_back();
+        }
+        else
+        {
+            while (nextPart < wireParts.size() && wireParts[nextPart].nextRow == wireParts[nextPart].numRows)
+            {
+                nextPart++;
+            }
+            if (nextPart == wireParts.size())
+            {
+                break;
+            }
+            p = nextPart;
+        }
+        PrintTableWirePart& part = wireParts[p];
+        for (size_t c = 0; c < merged.columns.size(); c++)
+        {
+            PrintTableColumn& column = merged.columns[c];
+            PrintTableWirePart::Column& wireColumn = part.columns[c];
+            if (part.IsNull(c, part.nextRow))
+            {
+                PrintTableAppendValidity(column, false);
+                continue;
+            }
+            const char* value = wireColumn.values[wireColumn.nextValue];
+            int64_t number = 0;
+            if (wireColumn.typed)
+            {
+                memcpy(&number, value, sizeof(number));
+            }
+            // Numbers of the merged scale are appended as they are, anything else goes through the text of the cell
+            if (wireColumn.typed && column.typedStorage && wireColumn.scale == column.scale)
+            {
+                PrintTableAppendValidity(column, true);
+                column.numbers.PushBack(number);
+            }
+            else if (wireColumn.typed)
+            {
+                PrintTableAppendToColumn(column, PrintTableFormatScaled(number, wireColumn.scale));
+            }
+            else
+            {
+                text.assign(value, wireColumn.lengths[wireColumn.nextValue]);
+                PrintTableAppendToColumn(column, text);
+            }
+            wireColumn.nextValue++;
+        }
+        merged.AppendRowMetadata(merged.numRows++);
+        part.nextRow++;
+        if (key >= 0 && part.nextRow < part.numRows)
+        {
+            heap.push_back(p);
+            std::push_heap(heap.begin(), heap.end(), greater);
+        }
+    }
+    merged.restoringWidths = false;
 
-    //Functions
-    void SetTitle(const std::string& title);
-    void AddColumn(const std::string& columnName);
-    void AddRow(const std::vector<std::string>& row);
-    void AddRows(const std::vector<std::vector<std::string>>& rows);
-    void Print();
-    void Reset();
-};
+    // The widths of the parts are summarized per column, so every chunk takes the widest part as its bound
+    for (size_t c = 0; c < merged.columns.size(); c++)
+    {
+        merged.columns[c].maxCellWidth = 0;
+        for (const PrintTableWirePart& part : wireParts)
+        {
+            merged.columns[c].maxCellWidth = std::max(merged.columns[c].maxCellWidth, part.columns[c].maxCellWidth);
+        }
+        for (PrintTableChunk& chunk : merged.chunks)
+        {
+            chunk.maxCellWidths[c] = merged.columns[c].maxCellWidth;
+        }
+    }
+    merged.alteredState = true;
+    return merged;
+}
 
-#endif // PRINT_TABLE_H
+size_t PrintTableView::NumRows() const
+{
+    return tables.empty() ? 0 : rowSources.size() / tables.size();
+}
 
-#ifdef PRINT_TABLE_IMPLEMENTATION
-void PrintTable::SetTitle(const std::string& title)
+int PrintTableView::CellWidth(size_t row, size_t column) const
 {
-    this->title = title;
-    alteredState = true;
+    const size_t table = columnTables[column];
+    const size_t sourceRow = rowSources[row * tables.size() + table];
+    return sourceRow == PRINT_TABLE_NO_ROW ? 0 : tables[table]->CellWidth(sourceRow, columnSources[column]);
 }
 
-void PrintTable::AddColumn(const std::string& columnName)
+std::string PrintTableView::Cell(size_t row, size_t column) const
 {
-    if (startedAddingRows)
+    const size_t table = columnTables[column];
+    const size_t sourceRow = rowSources[row * tables.size() + table];
+    if (sourceRow == PRINT_TABLE_NO_ROW)
     {
-        printf("Table '%s' already has rows added: additional columns cannot be added.\n", title.c_str());
-        return;
+        return "";
     }
-    columnNames.push_back(columnName);
-    alteredState = true;
+    return tables[table]->Cell(sourceRow, columnSources[column]);
 }
 
-void PrintTable::AddRow(const std::vector<std::string>& row)
+void PrintTableView::Render(std::string& output) const
 {
-    if (row.size() != columnNames.size())
+    if (columnNames.empty())
     {
-        printf("Trying to add row with %lu elements while table '%s' requires %lu elements per row.\n", row.size(), title.c_str(), columnNames.size());
+        output += "View '" + title + "' has no columns to print.\n";
         return;
     }
-    rows.push_back(row);
-    startedAddingRows = true;
-    alteredState = true;
+
+    // Format the referenced cells once and find the max width of each column over the selected rows only.
+    // Visuals have a fixed width, any other cell is as wide as its text.
+    const size_t numRows = NumRows();
+    std::vector<std::string> cells(numRows * columnNames.size());
+    std::vector<int> cellWidths(numRows * columnNames.size());
+    std::vector<int> maxColumnWidths(columnNames.size());
+    std::vector<int> visualWidths(columnNames.size(), -1);
+    for (size_t c = 0; c < columnNames.size(); c++)
+    {
+        maxColumnWidths[c] = columnNames[c].length();
+        const PrintTable& source = *tables[columnTables[c]];
+        if (columnSources[c] >= source.columns.size() && source.computedColumns[columnSources[c] - source.columns.size()].visual != PrintTableVisual::None)
+        {
+            visualWidths[c] = source.computedColumns[columnSources[c] - source.columns.size()].width;
+        }
+    }
+    for (size_t r = 0; r < numRows; r++)
+    {
+        for (size_t c = 0; c < columnNames.size(); c++)
+        {
+            std::string& cell = cells[r * columnNames.size() + c];
+            cell = Cell(r, c);
+            const bool missing = rowSources[r * tables.size() + columnTables[c]] == PRINT_TABLE_NO_ROW;
+            const int width = visualWidths[c] >= 0 && !missing ? visualWidths[c] : int(cell.length());
+            cellWidths[r * columnNames.size() + c] = width;
+            maxColumnWidths[c] = std::max(maxColumnWidths[c], width);
+        }
+    }
+
+    int tableWidth = 1;
+    for (const int& width : maxColumnWidths)
+    {
+        tableWidth += width + 3;
+    }
+    const std::string fullDividerStr(tableWidth, '-');
+    std::string titleStr;
+    PrintTableAppendCell(titleStr, title, tableWidth - 4);
+    titleStr += "|";
+    std::string columnStr;
+    for (size_t c = 0; c < columnNames.size(); c++)
+    {
+        PrintTableAppendCell(columnStr, columnNames[c], maxColumnWidths[c]);
+    }
+    columnStr += "|";
+
+    output += fullDividerStr + "\n";
+    output += titleStr + "\n";
+    output += fullDividerStr + "\n";
+    output += columnStr + "\n";
+    output += fullDividerStr + "\n";
+    for (size_t r = 0; r < numRows; r++)
+    {
+        for (size_t c = 0; c < columnNames.size(); c++)
+        {
+            const std::string& cell = cells[r * columnNames.size() + c];
+            const int width = cellWidths[r * columnNames.size() + c];
+            const bool alignRight = tables[columnTables[c]]->IsNumericColumn(columnSources[c]);
+            if (highlightPattern.empty())
+            {
+                PrintTableAppendCell(output, cell, maxColumnWidths[c], width, alignRight);
+            }
+            else
+            {
+                // The escape sequences take up no space, so the cell is padded according to its plain width
+                PrintTableAppendCell(output, PrintTableHighlight(cell, highlightPattern), maxColumnWidths[c], width, alignRight);
+            }
+        }
+        output += "|\n";
+    }
+    output += fullDividerStr + "\n";
 }
 
-void PrintTable::AddRows(const std::vector<std::vector<std::string>>& rows)
+void PrintTableView::Print() const
 {
-    for (const std::vector<std::string>& row : rows)
+    std::string output;
+    Render(output);
+    fwrite(output.data(), 1, output.length(), stdout);
+}
+
+// Appends a cell of a CSV record, quoted if it contains a separator, quote or line break
+static void PrintTableAppendCsvCell(std::string& output, const std::string& cell, bool first)
+{
+    if (!first)
     {
-        if (row.size() != columnNames.size())
+        output += ',';
+    }
+    if (cell.find_first_of(",\"\r\n") == std::string::npos)
+    {
+        output += cell;
+        return;
+    }
+    output += '"';
+    for (const char c : cell)
+    {
+        output += c;
+        if (c == '"')
         {
-            printf("Trying to add row with %lu elements while table '%s' requires %lu elements per row.\n", row.size(), title.c_str(), columnNames.size());
+            output += '"';
         }
-        this->rows.push_back(row);
     }
-    startedAddingRows = true;
-    alteredState = true;
+    output += '"';
 }
 
-void PrintTable::Print()
+#ifdef PRINT_TABLE_POSIX
+// Sends the pieces of a response with as few system calls as possible, pointing at the cached row strings instead of
+// copying them. Once the socket stops taking data, the remaining pieces are copied to pending for later polls.
+struct PrintTableResponse
 {
-    if (title.empty() || columnNames.empty() || rows.empty())
+    int fd;
+    std::string& pending;
+    std::vector<iovec> pieces;
+    bool failed = false;
+
+    PrintTableResponse(int fd, std::string& pending) : fd(fd), pending(pending)
     {
-        printf("Missing some necessary data to print table:\n\tTitle: '%s' (must not be empty)\n\tNumber of columns: %lu (min=1)\n\tNumber of rows: %lu (min=1)\n", title.c_str(), columnNames.size(), rows.size());
-        return;
     }
-    if (alteredState)
+
+    void Add(const char* data, size_t length)
     {
-        // Find max width of each column
-        maxColumnWidths.resize(columnNames.size());
-        for (size_t i = 0; i < columnNames.size(); i++)
+        if (failed || length == 0)
+        {
+            return;
+        }
+        if (!pending.empty())
         {
-            maxColumnWidths[i] = columnNames[i].length();
+            pending.append(data, length);
+            return;
         }
-        for (size_t r = 0; r < rows.size(); r++)
+        pieces.push_back({ (void*)data, length });
+        if (pieces.size() == 1024)
         {
-            for (size_t c = 0; c < columnNames.size(); c++)
+            Flush();
+        }
+    }
+
+    void Add(const std::string& text)
+    {
+        Add(text.data(), text.length());
+    }
+
+    // Must be called before the strings added so far change
+    void Flush()
+    {
+        size_t sent = 0;
+        size_t i = 0;
+        while (i < pieces.size())
+        {
+            msghdr message = msghdr();
+            message.msg_iov = pieces.data() + i;
+            message.msg_iovlen = std::min(pieces.size() - i, size_t(1024));
+#ifdef MSG_NOSIGNAL
+            const ssize_t result = sendmsg(fd, &message, MSG_NOSIGNAL);
+#else
+            const ssize_t result = sendmsg(fd, &message, 0);
+#endif
+            if (result < 0)
             {
-                if (int(rows[r][c].length()) > maxColumnWidths[c])
+                failed = errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR;
+                if (failed || errno != EINTR)
                 {
-                    maxColumnWidths[c] = rows[r][c].length();
+                    break;
                 }
+                continue;
+            }
+            // Skip the pieces that were sent completely and trim the one that was sent partially
+            sent = result;
+            while (i < pieces.size() && sent >= pieces[i].iov_len)
+            {
+                sent -= pieces[i++].iov_len;
+            }
+            if (i < pieces.size())
+            {
+                pieces[i].iov_base = (char*)pieces[i].iov_base + sent;
+                pieces[i].iov_len -= sent;
+                break;
             }
         }
-
-        /*
-        -------------------------------
-        |          Test table         |
-        -------------------------------
-        | column0 | column1 | column2 |
-        -------------------------------
-        |  row0   |  row0   |  row0   |
-        |-----------------------------|
-        |  row1   |  row1   |  row1   |
-        |-----------------------------|
-        |  row2   |  row2   |  row2   |
-        -------------------------------
-        */
-        int tableWidth = 0;
-        for (const int& width : maxColumnWidths)
+        for (; i < pieces.size() && !failed; i++)
         {
-            // +3 because it includes the space for the first |
-            // and a space on each side of the column name (see above example)
-            tableWidth += width + 3;
+            pending.append((const char*)pieces[i].iov_base, pieces[i].iov_len);
         }
-        // Make space for the last |
-        tableWidth += 1;
-        fullDividerStr = std::string(tableWidth, '-');
+        pieces.clear();
+    }
+};
 
-        // Create string with title
-        titleStr = "";
+PrintTableServer::~PrintTableServer()
+{
+    Close();
+}
+
+bool PrintTableServer::Listen(const std::string& path)
+{
+    sockaddr_un address = sockaddr_un();
+    address.sun_family = AF_UNIX;
+    if (path.length() >= sizeof(address.sun_path))
+    {
+        printf("Socket path '%s' is longer than the %lu characters a Unix domain socket allows.\n", path.c_str(), sizeof(address.sun_path) - 1);
+        return false;
+    }
+    Close();
+    memcpy(address.sun_path, path.c_str(), path.length() + 1);
+    unlink(path.c_str());
+    listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0 || bind(listenFd, (const sockaddr*)&address, sizeof(address)) != 0 || listen(listenFd, 64) != 0 || fcntl(listenFd, F_SETFL, O_NONBLOCK) != 0)
+    {
+        printf("Could not listen on socket '%s'.\n", path.c_str());
+        Close();
+        return false;
+    }
+    this->path = path;
+#ifdef __linux__
+    epollFd = epoll_create1(0);
+    epoll_event event = epoll_event();
+    event.events = EPOLLIN;
+    event.data.fd = listenFd;
+    if (epollFd < 0 || epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event) != 0)
+    {
+        printf("Could not listen on socket '%s'.\n", path.c_str());
+        Close();
+        return false;
+    }
+#endif
+    return true;
+}
+
+void PrintTableServer::Register(const std::string& name, PrintTable& table)
+{
+    tables[name] = &table;
+}
+
+void PrintTableServer::Unregister(const std::string& name)
+{
+    tables.erase(name);
+}
+
+void PrintTableServer::Poll(int timeoutMs)
+{
+    if (listenFd < 0)
+    {
+        return;
+    }
+    // Sockets that are readable or writable, or whose peer hung up
+    std::vector<int> ready;
+#ifdef __linux__
+    epoll_event events[64];
+    const int numEvents = epoll_wait(epollFd, events, 64, timeoutMs);
+    for (int i = 0; i < numEvents; i++)
+    {
+        ready.push_back(events[i].data.fd);
+    }
+#else
+    std::vector<pollfd> fds(1, pollfd());
+    fds[0].fd = listenFd;
+    fds[0].events = POLLIN;
+    for (const std::pair<const int, Client>& client : clients)
+    {
+        pollfd fd = pollfd();
+        fd.fd = client.first;
+        fd.events = client.second.pending.empty() ? POLLIN : POLLOUT;
+        fds.push_back(fd);
+    }
+    if (poll(fds.data(), fds.size(), timeoutMs) > 0)
+    {
+        for (const pollfd& fd : fds)
         {
-            // Subtract 4 to ensure that the inital, and last, | and space are ignored
-            const int lengthDiff = (tableWidth - 4) - title.length();
-            // Divide by 2 to get number of pre spaces
-            const int numPreSpace = lengthDiff / 2;
-            // Divide by 2, but increment lengthDiff by one to round up.
-            // I do this because I want extra spaces after the column name
-            const int numPostSpace = (lengthDiff + 1) / 2;
-            const std::string preStr(numPreSpace, ' ');
-            const std::string postStr(numPostSpace, ' ');
-            titleStr += "| " + preStr + title + postStr + " |";
+            if (fd.revents != 0)
+            {
+                ready.push_back(fd.fd);
+            }
         }
+    }
+#endif
 
-        // Create string with each column name
-        columnStr = "";
-        for (size_t i = 0; i < columnNames.size(); i++)
+    for (const int fd : ready)
+    {
+        if (fd == listenFd)
         {
-            const std::string& columnName = columnNames[i];
-            const int lengthDiff = maxColumnWidths[i] - columnName.length();
-            if (lengthDiff > 0)
+            for (int clientFd = accept(listenFd, nullptr, nullptr); clientFd >= 0; clientFd = accept(listenFd, nullptr, nullptr))
             {
-                // Divide by 2 to get number of pre spaces
-                const int numPreSpace = lengthDiff / 2;
-                // Divide by 2, but increment lengthDiff by one to round up.
-                // I do this because I want extra spaces after the column name
-                const int numPostSpace = (lengthDiff + 1) / 2;
-                const std::string preStr(numPreSpace, ' ');
-                const std::string postStr(numPostSpace, ' ');
-                columnStr += "| " + preStr + columnName + postStr + " ";
+                fcntl(clientFd, F_SETFL, O_NONBLOCK);
+#ifdef SO_NOSIGPIPE
+                const int enabled = 1;
+                setsockopt(clientFd, SOL_SOCKET, SO_NOSIGPIPE, &enabled, sizeof(enabled));
+#endif
+#ifdef __linux__
+                epoll_event event = epoll_event();
+                event.events = EPOLLIN;
+                event.data.fd = clientFd;
+                epoll_ctl(epollFd, EPOLL_CTL_ADD, clientFd, &event);
+#endif
+                clients[clientFd] = Client();
             }
-            else
+            continue;
+        }
+        const auto it = clients.find(fd);
+        if (it == clients.end())
+        {
+            continue;
+        }
+        Client& client = it->second;
+        if (client.responding)
+        {
+            PrintTableResponse response(fd, client.pending);
+            std::string unsent;
+            unsent.swap(client.pending);
+            response.Add(unsent);
+            response.Flush();
+            if (response.failed || client.pending.empty())
             {
-                columnStr += "| " + columnName + " ";
+                CloseClient(fd);
             }
+            continue;
         }
-        columnStr += "|";
+        char buffer[4096];
+        const ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+        if (received <= 0)
+        {
+            if (received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+            {
+                CloseClient(fd);
+            }
+            continue;
+        }
+        client.request.append(buffer, received);
+        if (client.request.find('\n') != std::string::npos)
+        {
+            Respond(fd, client);
+        }
+        else if (client.request.length() > 65536)
+        {
+            CloseClient(fd);
+        }
+    }
+}
+
+void PrintTableServer::Respond(int fd, Client& client)
+{
+    client.responding = true;
+    std::string line = client.request.substr(0, client.request.find('\n'));
+    if (!line.empty() && line.back() == '\r')
+    {
+        line.pop_back();
+    }
+    std::vector<std::string> fields;
+    for (size_t start = 0;;)
+    {
+        const size_t end = line.find('\t', start);
+        fields.push_back(line.substr(start, end - start));
+        if (end == std::string::npos)
+        {
+            break;
+        }
+        start = end + 1;
+    }
+    std::string query;
+    std::string pattern;
+    std::string format = "text";
+    size_t firstRow = 0;
+    size_t maxRows = size_t(-1);
+    std::string error;
+    for (size_t f = 1; f < fields.size() && error.empty(); f++)
+    {
+        const size_t equals = fields[f].find('=');
+        const std::string option = fields[f].substr(0, equals);
+        const std::string value = equals == std::string::npos ? std::string() : fields[f].substr(equals + 1);
+        if (option == "query")
+        {
+            query = value;
+        }
+        else if (option == "grep")
+        {
+            pattern = value;
+        }
+        else if (option == "format" && (value == "text" || value == "csv"))
+        {
+            format = value;
+        }
+        else if (option == "rows" && sscanf(value.c_str(), "%lu:%lu", &firstRow, &maxRows) == 2)
+        {
+        }
+        else
+        {
+            error = "Unknown option '" + fields[f] + "'.\n";
+        }
+    }
+    const auto it = tables.find(fields[0]);
+    if (error.empty() && it == tables.end())
+    {
+        error = "No table named '" + fields[0] + "' is served.\n";
+    }
 
-        // Create string for each row and its elements
-        rowStrs = std::vector<std::string>(rows.size());
-        for (size_t r = 0; r < rows.size(); r++)
+    PrintTableResponse response(fd, client.pending);
+    std::string output;
+    if (!error.empty())
+    {
+        output = error;
+    }
+    else if (!query.empty() || !pattern.empty() || format == "csv")
+    {
+        // Filtered and CSV renders are built from a view of the selected rows. Grep searches all columns, so only
+        // a query can be invalid.
+        PrintTable& table = *it->second;
+        PrintTableView view = !query.empty() ? table.Query(query, &error) : !pattern.empty() ? table.Grep(pattern) : table.Query("select *");
+        const size_t numRows = view.NumRows();
+        const size_t stride = view.tables.size();
+        const size_t first = std::min(firstRow, numRows);
+        const size_t last = first + std::min(maxRows, numRows - first);
+        view.rowSources = std::vector<size_t>(view.rowSources.begin() + first * stride, view.rowSources.begin() + last * stride);
+        if (!error.empty())
         {
-            for (size_t e = 0; e < rows[r].size(); e++)
+            output = error;
+        }
+        else if (format == "text")
+        {
+            view.Render(output);
+        }
+        else
+        {
+            for (size_t c = 0; c < view.columnNames.size(); c++)
+            {
+                PrintTableAppendCsvCell(output, view.columnNames[c], c == 0);
+            }
+            output += "\n";
+            for (size_t r = 0; r < view.NumRows(); r++)
+            {
+                for (size_t c = 0; c < view.columnNames.size(); c++)
+                {
+                    PrintTableAppendCsvCell(output, view.Cell(r, c), c == 0);
+                }
+                output += "\n";
+            }
+        }
+    }
+    else if (it->second->title.empty() || it->second->columnNames.empty() || it->second->numRows == 0)
+    {
+        output = "Table '" + fields[0] + "' has nothing to print yet.\n";
+    }
+    else
+    {
+        // Plain renders point straight at the format data and row strings cached by the table
+        PrintTable& table = *it->second;
+        table.BuildFormat();
+        const char* newline = "\n";
+        for (const std::string* str : { &table.fullDividerStr, &table.titleStr, &table.fullDividerStr })
+        {
+            response.Add(*str);
+            response.Add(newline, 1);
+        }
+        for (const std::string& groupStr : table.columnGroupStrs)
+        {
+            response.Add(groupStr);
+            response.Add(newline, 1);
+            response.Add(table.fullDividerStr);
+            response.Add(newline, 1);
+        }
+        response.Add(table.columnStr);
+        response.Add(newline, 1);
+        response.Add(table.fullDividerStr);
+        response.Add(newline, 1);
+        const size_t first = std::min(firstRow, table.numRows);
+        const size_t last = first + std::min(maxRows, table.numRows - first);
+        std::vector<std::string> sealedRowStrs;
+        for (size_t i = first / PRINT_TABLE_CHUNK_ROWS; i * PRINT_TABLE_CHUNK_ROWS < last; i++)
+        {
+            const std::vector<std::string>& rowStrs = table.ChunkRowStrs(i, sealedRowStrs);
+            for (size_t r = std::max(first, i * PRINT_TABLE_CHUNK_ROWS); r < std::min(last, (i + 1) * PRINT_TABLE_CHUNK_ROWS); r++)
             {
-                const std::string& elementData = rows[r][e];
-                const int lengthDiff = maxColumnWidths[e] - elementData.length();
-                // Divide by 2 to get number of pre spaces
-                const int numPreSpace = lengthDiff / 2;
-                // Divide by 2, but increment lengthDiff by one to round up.
-                // I do this because I want extra spaces after the column name
-                const int numPostSpace = (lengthDiff + 1) / 2;
-                const std::string preStr(numPreSpace, ' ');
-                const std::string postStr(numPostSpace, ' ');
-                rowStrs[r] += "| " + preStr + elementData + postStr + " ";
+                response.Add(rowStrs[r - i * PRINT_TABLE_CHUNK_ROWS]);
+                response.Add(newline, 1);
             }
-            rowStrs[r] += "|";
+            // The sealed rows are overwritten by the next chunk
+            response.Flush();
         }
+        response.Add(table.fullDividerStr);
+        response.Add(newline, 1);
     }
+    response.Add(output);
+    response.Flush();
+    if (response.failed || client.pending.empty())
+    {
+        CloseClient(fd);
+        return;
+    }
+#ifdef __linux__
+    epoll_event event = epoll_event();
+    event.events = EPOLLOUT;
+    event.data.fd = fd;
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &event);
+#endif
+}
 
-    // Print table
-    printf("%s\n", fullDividerStr.c_str());
-    printf("%s\n", titleStr.c_str());
-    printf("%s\n", fullDividerStr.c_str());
-    printf("%s\n", columnStr.c_str());
-    printf("%s\n", fullDividerStr.c_str());
-    for (const std::string& rowStr : rowStrs)
+void PrintTableServer::CloseClient(int fd)
+{
+    // Closing the socket also removes it from the epoll set
+    close(fd);
+    clients.erase(fd);
+}
+
+void PrintTableServer::Close()
+{
+    while (!clients.empty())
     {
-        printf("%s\n", rowStr.c_str());
+        CloseClient(clients.begin()->first);
     }
-    printf("%s\n", fullDividerStr.c_str());
+    if (epollFd >= 0)
+    {
+        close(epollFd);
+        epollFd = -1;
+    }
+    if (listenFd >= 0)
+    {
+        close(listenFd);
+        listenFd = -1;
+        unlink(path.c_str());
+    }
+}
+#else
+PrintTableServer::~PrintTableServer()
+{
+}
 
-    alteredState = false;
+bool PrintTableServer::Listen(const std::string& path)
+{
+    printf("Could not listen on socket '%s': the table server needs Unix domain sockets.\n", path.c_str());
+    return false;
 }
 
-void PrintTable::Reset()
+void PrintTableServer::Register(const std::string& name, PrintTable& table)
+{
+    tables[name] = &table;
+}
+
+void PrintTableServer::Unregister(const std::string& name)
+{
+    tables.erase(name);
+}
+
+void PrintTableServer::Poll(int)
+{
+}
+
+void PrintTableServer::Respond(int, Client&)
+{
+}
+
+void PrintTableServer::CloseClient(int)
+{
+}
+
+void PrintTableServer::Close()
 {
-    title = "";
-    columnNames.resize(0);
-    rows.resize(0);
-    maxColumnWidths.resize(0);
-    startedAddingRows = false;
-    alteredState = true;
 }
+#endif
 
 #endif // PRINT_TABLE_IMPLEMENTATION
\ No newline at end of file
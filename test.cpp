@@ -0,0 +1,991 @@
+#define PRINT_TABLE_IMPLEMENTATION
+#include "PrintTable.h"
+
+#include <csignal>
+#include <unistd.h>
+
+static int failures = 0;
+
+#define CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            failures++; \
+        } \
+    } while (0)
+
+// Returns what print writes to stdout, which is redirected to a temporary file meanwhile
+template <typename Function>
+static std::string Captured(Function print)
+{
+    fflush(stdout);
+    FILE* file = tmpfile();
+    const int savedStdout = dup(1);
+    dup2(fileno(file), 1);
+    print();
+    fflush(stdout);
+    dup2(savedStdout, 1);
+    close(savedStdout);
+    rewind(file);
+    std::string output;
+    char buffer[4096];
+    size_t length;
+    while ((length = fread(buffer, 1, sizeof(buffer), file)) > 0)
+    {
+        output.append(buffer, length);
+    }
+    fclose(file);
+    return output;
+}
+
+static std::string Printed(PrintTable& table)
+{
+    return Captured([&]() { table.Print(); });
+}
+
+static void TestColumnGroups()
+{
+    PrintTable table;
+    table.SetTitle("Service latency report");
+    table.AddColumn("host");
+    table.AddColumn("p50");
+    table.AddColumn("p95");
+    table.AddColumn("p99");
+    table.AddColumnGroup("Latency measured in milliseconds", 1, 3);
+    table.AddColumnGroup("All", 0, 4, 1);
+    table.AddRow({ "a", "1", "2", "3" });
+    table.AddRow({ "bbbb", "10", "20", "300" });
+    const std::string expected =
+        "-------------------------------------------\n"
+        "|         Service latency report          |\n"
+        "-------------------------------------------\n"
+        "|                   All                   |\n"
+        "-------------------------------------------\n"
+        "|      | Latency measured in milliseconds |\n"
+        "-------------------------------------------\n"
+        "| host |   p50    |   p95    |    p99     |\n"
+        "-------------------------------------------\n"
+        "|  a   |    1     |    2     |     3      |\n"
+        "| bbbb |    10    |    20    |    300     |\n"
+        "-------------------------------------------\n";
+    CHECK(Printed(table) == expected);
+
+    // Overlapping groups on one level are rejected
+    const std::string error = Captured([&]() { table.AddColumnGroup("Overlap", 0, 2); });
+    CHECK(error.find("overlaps column group") != std::string::npos);
+    CHECK(table.columnGroups.size() == 2);
+}
+
+static void TestJoin()
+{
+    PrintTable jobs;
+    jobs.SetTitle("Jobs");
+    jobs.AddColumn("job");
+    jobs.AddColumn("host");
+    jobs.SetNullMarker("");
+    jobs.AddRow({ "1", "h1" });
+    jobs.AddRow({ "2", "h2" });
+    jobs.AddRow({ "3", "h9" });
+    jobs.AddRow({ "4", "" });
+    jobs.AddRow({ "5", "-" });
+    PrintTable hosts;
+    hosts.SetTitle("Hosts");
+    hosts.AddColumn("host");
+    hosts.AddColumn("region");
+    hosts.SetNullMarker("");
+    hosts.AddRow({ "h1", "eu" });
+    hosts.AddRow({ "h2", "us" });
+    hosts.AddRow({ "", "nowhere" });
+
+    const PrintTableView inner = PrintTable::Join(jobs, hosts, { "host" });
+    CHECK(inner.NumRows() == 2);
+    CHECK(inner.Cell(0, 0) == "1" && inner.Cell(0, 2) == "eu");
+    CHECK(inner.Cell(1, 0) == "2" && inner.Cell(1, 2) == "us");
+
+    // Null keys match neither each other nor the null text, but left joins keep their rows
+    const PrintTableView left = PrintTable::Join(jobs, hosts, { "host" }, PrintTableJoinKind::Left);
+    CHECK(left.NumRows() == 5);
+    CHECK(left.Cell(3, 0) == "4" && left.Cell(3, 2) == "");
+    CHECK(left.Cell(4, 0) == "5" && left.Cell(4, 2) == "");
+
+    const std::string error = Captured([&]() { PrintTable::Join(jobs, hosts, { "nope" }); });
+    CHECK(error.find("must exist in both") != std::string::npos);
+
+    // Keys of several columns do not collide whatever bytes their cells contain
+    PrintTable a;
+    a.SetTitle("A");
+    a.AddColumn("x");
+    a.AddColumn("y");
+    a.AddRow({ "p\x1fq", "r" });
+    PrintTable b;
+    b.SetTitle("B");
+    b.AddColumn("x");
+    b.AddColumn("y");
+    b.AddRow({ "p", "q\x1fr" });
+    b.AddRow({ "p\x1fq", "r" });
+    const PrintTableView pairs = PrintTable::Join(a, b, { "x", "y" });
+    CHECK(pairs.rowSources == std::vector<size_t>({ 0, 1 }));
+}
+
+static void AddJobColumns(PrintTable& table)
+{
+    table.SetTitle("Jobs");
+    table.AddColumn("job");
+    table.AddColumn("host");
+    table.AddColumn("status");
+}
+
+static void TestDiff()
+{
+    PrintTable previous;
+    AddJobColumns(previous);
+    previous.AddRow({ "1", "h1", "ok" });
+    previous.AddRow({ "2", "h2", "failed" });
+    previous.AddRow({ "3", "h9", "ok" });
+    PrintTable current;
+    AddJobColumns(current);
+    current.AddRow({ "1", "h1", "ok" });
+    current.AddRow({ "2", "h3", "running" });
+    current.AddRow({ "4", "h9", "ok" });
+
+    PrintTable diff = PrintTable::Diff(previous, current, { "job" });
+    CHECK(diff.NumRows() == 3);
+    CHECK(diff.Cell(0, 0) == "~" && diff.Cell(0, 1) == "2" && diff.Cell(0, 2) == "h2 -> h3" && diff.Cell(0, 3) == "failed -> running");
+    CHECK(diff.Cell(1, 0) == "+" && diff.Cell(1, 1) == "4");
+    CHECK(diff.Cell(2, 0) == "-" && diff.Cell(2, 1) == "3");
+    CHECK(PrintTable::Diff(previous, previous, { "job" }).NumRows() == 0);
+
+    // A null key matches no other key, not even another null or the null text
+    PrintTable before;
+    AddJobColumns(before);
+    before.SetNullMarker("NA");
+    before.AddRows({ { "NA", "h1", "ok" }, { "-", "h2", "ok" } });
+    PrintTable after;
+    AddJobColumns(after);
+    after.SetNullMarker("NA");
+    after.AddRows({ { "-", "h2", "ok" }, { "NA", "h1", "ok" } });
+    PrintTable nullDiff = PrintTable::Diff(before, after, { "job" });
+    CHECK(nullDiff.NumRows() == 2);
+    CHECK(nullDiff.Cell(0, 0) == "+" && nullDiff.Cell(0, 2) == "h1" && nullDiff.Cell(1, 0) == "-" && nullDiff.Cell(1, 2) == "h1");
+}
+
+static void TestFingerprint()
+{
+    PrintTable first;
+    AddJobColumns(first);
+    first.AddRow({ "1", "h1", "ok" });
+    first.AddRow({ "2", "h2", "failed" });
+    PrintTable second;
+    AddJobColumns(second);
+    second.AddRow({ "1", "h1", "ok" });
+    second.AddRow({ "2", "h2", "failed" });
+    CHECK(first.Fingerprint() == second.Fingerprint());
+
+    // Only content changes since the last print make PrintIfChanged print
+    bool printed = false;
+    CHECK(!Captured([&]() { printed = first.PrintIfChanged(); }).empty() && printed);
+    CHECK(Captured([&]() { printed = first.PrintIfChanged(); }).empty() && !printed);
+    first.SetCell(1, 2, "ok");
+    CHECK(first.Fingerprint() != second.Fingerprint());
+    CHECK(!Captured([&]() { printed = first.PrintIfChanged(); }).empty() && printed);
+    first.SetCell(1, 2, "failed");
+    CHECK(first.Fingerprint() == second.Fingerprint());
+}
+
+static void TestGrep()
+{
+    // The vectorized search agrees with std::string::find on haystacks of every length
+    srand(1);
+    for (int i = 0; i < 20000; i++)
+    {
+        std::string haystack;
+        std::string needle;
+        const int haystackLength = rand() % 60;
+        const int needleLength = rand() % 5;
+        for (int k = 0; k < haystackLength; k++)
+        {
+            haystack += "ab"[rand() % 2];
+        }
+        for (int k = 0; k < needleLength; k++)
+        {
+            needle += "ab"[rand() % 2];
+        }
+        const char* match = PrintTableFind(haystack.data(), haystack.length(), needle.data(), needle.length());
+        CHECK((match == nullptr ? std::string::npos : size_t(match - haystack.data())) == haystack.find(needle));
+    }
+
+    PrintTable table;
+    AddJobColumns(table);
+    table.AddRow({ "1", "host-eu-1", "ok" });
+    table.AddRow({ "2", "host-us-2", "failed eu" });
+    table.AddRow({ "3", "h9", "ok" });
+    CHECK(table.Grep("eu").rowSources == std::vector<size_t>({ 0, 1 }));
+    CHECK(table.Grep("eu", { "host" }).rowSources == std::vector<size_t>({ 0 }));
+    CHECK(table.Grep("nothing").NumRows() == 0);
+    const std::string highlighted = Captured([&]() { table.Grep("eu", { "host" }, true).Print(); });
+    CHECK(highlighted.find("host-\x1b[1;31meu\x1b[0m-1") != std::string::npos);
+    CHECK(Captured([&]() { table.Grep("eu", { "x" }); }).find("Column 'x' does not exist") != std::string::npos);
+}
+
+static void TestTrigramIndex()
+{
+    PrintTable table;
+    table.SetTitle("Hosts");
+    table.AddColumn("id");
+    table.AddColumn("host");
+    for (int i = 0; i < 20000; i++)
+    {
+        table.AddRow({ std::to_string(i), "host-" + std::to_string(i * 7919LL % 100003) });
+    }
+    PrintTable scanned = table;
+    table.CreateTrigramIndex({ "host" });
+    const char* patterns[] = { "123", "host-9", "45", "00", "zzz", "t-1" };
+    for (const char* pattern : patterns)
+    {
+        CHECK(table.Grep(pattern, { "host" }).rowSources == scanned.Grep(pattern, { "host" }).rowSources);
+    }
+
+    // Rows added and cells changed after the index was built are found too
+    table.AddRow({ "x", "zz12345" });
+    table.SetCell(0, 1, "changed-777");
+    scanned.AddRow({ "x", "zz12345" });
+    scanned.SetCell(0, 1, "changed-777");
+    CHECK(table.Grep("12345", { "host" }).rowSources == scanned.Grep("12345", { "host" }).rowSources);
+    CHECK(table.Grep("777", { "host" }).rowSources == scanned.Grep("777", { "host" }).rowSources);
+    CHECK(table.Grep("777", { "host" }).rowSources.front() == 0);
+}
+
+static void TestIndexes()
+{
+    PrintTable table;
+    table.SetTitle("Numbers");
+    table.AddColumn("id");
+    table.AddColumn("n");
+    const char* values[] = { "1000", "150", "99", "200", "1999999", "100", "150" };
+    std::vector<std::vector<std::string>> rows;
+    for (size_t i = 0; i < 7; i++)
+    {
+        rows.push_back({ std::to_string(i), values[i] });
+    }
+    // Only AddRows infers the column types
+    table.AddRows(rows);
+    CHECK(table.columns[1].type == PrintTableColumnType::Integer);
+    PrintTable scanned = table;
+    PrintTable hashed = table;
+    table.CreateIndex("n", PrintTableIndexKind::Sorted);
+    hashed.CreateIndex("n", PrintTableIndexKind::Hash);
+
+    // An index created before the types were inferred is rebuilt on the numbers
+    PrintTable early;
+    early.SetTitle("Numbers");
+    early.AddColumn("id");
+    early.AddColumn("n");
+    early.CreateIndex("n", PrintTableIndexKind::Sorted);
+    early.AddRows(rows);
+
+    // Ranges on integer columns compare numbers, not text, and come back in order
+    const std::vector<size_t> expected({ 5, 1, 6, 3 });
+    CHECK(table.Range("n", "100", "200").rowSources == expected);
+    CHECK(scanned.Range("n", "100", "200").rowSources == expected);
+    CHECK(early.Range("n", "100", "200").rowSources == expected);
+    CHECK(table.Range("n", "99.5", "200.5").rowSources == expected);
+    CHECK(table.Range("n", "200", "100").NumRows() == 0);
+    CHECK(Captured([&]() { table.Range("n", "a", "z"); }).find("must be bounded by numbers") != std::string::npos);
+    CHECK(table.Lookup("n", "150").rowSources == std::vector<size_t>({ 1, 6 }));
+    CHECK(hashed.Lookup("n", "150").rowSources == std::vector<size_t>({ 1, 6 }));
+
+    // Changed cells move in the index, and a cell that is not a number turns the column and its index back to text
+    table.SetCell(0, 1, "120");
+    CHECK(table.Range("n", "100", "200").rowSources == std::vector<size_t>({ 5, 0, 1, 6, 3 }));
+    table.SetCell(2, 1, "n/a");
+    CHECK(table.columns[1].type == PrintTableColumnType::Text);
+    CHECK(table.Range("n", "100", "200").rowSources == std::vector<size_t>({ 5, 0, 1, 6, 4, 3 }));
+    CHECK(table.Lookup("n", "n/a").rowSources == std::vector<size_t>({ 2 }));
+
+    // Numbers of different scales are not stored typed, so they keep their text order, with or without an index
+    PrintTable decimals;
+    decimals.SetTitle("Decimals");
+    decimals.AddColumn("n");
+    decimals.AddRows({ { "7.5" }, { "12" }, { "100.25" }, { "9" } });
+    CHECK(decimals.columns[0].type == PrintTableColumnType::Decimal && !decimals.columns[0].typedStorage);
+    const std::vector<size_t> textOrder({ 2, 1, 0 });
+    CHECK(decimals.Range("n", "100", "8").rowSources == textOrder);
+    decimals.CreateIndex("n", PrintTableIndexKind::Sorted);
+    CHECK(decimals.Range("n", "100", "8").rowSources == textOrder);
+}
+
+static void TestQuery()
+{
+    PrintTable table;
+    AddJobColumns(table);
+    table.AddColumn("seconds");
+    table.AddRows({ { "1", "h1", "ok", "12" }, { "2", "h2", "failed", "7.5" }, { "3", "h1", "failed", "100" }, { "4", "h3", "ok", "9" } });
+
+    const PrintTableView selected = table.Query("select job, seconds where host = \"h1\" or seconds < 8 order by seconds desc");
+    CHECK(selected.columnNames == std::vector<std::string>({ "job", "seconds" }));
+    CHECK(selected.rowSources == std::vector<size_t>({ 2, 0, 1 }));
+    // Numbers compare as numbers, not text
+    CHECK(table.Query("select * where seconds > 10").rowSources == std::vector<size_t>({ 0, 2 }));
+    CHECK(table.Query("select * where (status = \"ok\" and host != \"h1\") or job = 2 order by job limit 1").rowSources == std::vector<size_t>({ 1 }));
+    CHECK(table.Query("select * order by seconds limit 2").rowSources == std::vector<size_t>({ 1, 3 }));
+    CHECK(Captured([&]() { table.Query("select nope"); }).find("nope") != std::string::npos);
+    size_t numRows = 1;
+    CHECK(Captured([&]() { numRows = table.Query("select job where").NumRows(); }).find("Invalid query") != std::string::npos);
+    CHECK(numRows == 0);
+
+    // Only digits make a number, so "nan" is text: the column sorts as text and "nan" satisfies no numeric comparison
+    PrintTable odd;
+    AddJobColumns(odd);
+    odd.AddRows({ { "3", "h1", "ok" }, { "nan", "h2", "ok" }, { "1", "h3", "ok" }, { "2", "h4", "ok" } });
+    CHECK(odd.Query("select * order by job").rowSources == std::vector<size_t>({ 2, 3, 0, 1 }));
+    CHECK(odd.Query("select * where job > 1").rowSources == std::vector<size_t>({ 0, 3 }));
+}
+
+static void TestPivot()
+{
+    PrintTable sales;
+    sales.SetTitle("Sales");
+    sales.AddColumn("region");
+    sales.AddColumn("quarter");
+    sales.AddColumn("amount");
+    sales.AddRows({ { "eu", "q1", "10" }, { "us", "q1", "5" }, { "eu", "q2", "7" }, { "eu", "q1", "2.5" }, { "us", "q2", "n/a" } });
+
+    PrintTable sums = PrintTable::Pivot(sales, "region", "quarter", "amount", PrintTableAggregate::Sum);
+    CHECK(sums.NumRows() == 2 && sums.NumColumns() == 3);
+    CHECK(sums.ColumnName(0) == "region" && sums.ColumnName(1) == "q1" && sums.ColumnName(2) == "q2");
+    CHECK(sums.Cell(0, 0) == "eu" && sums.Cell(0, 1) == "12.5" && sums.Cell(0, 2) == "7");
+    CHECK(sums.Cell(1, 0) == "us" && sums.Cell(1, 1) == "5");
+    PrintTable counts = PrintTable::Pivot(sales, "region", "quarter", "amount", PrintTableAggregate::Count);
+    CHECK(counts.Cell(0, 1) == "2" && counts.Cell(1, 2) == "1");
+    PrintTable maxima = PrintTable::Pivot(sales, "region", "quarter", "amount", PrintTableAggregate::Max);
+    CHECK(maxima.Cell(0, 1) == "10");
+    CHECK(Captured([&]() { PrintTable::Pivot(sales, "region", "nope", "amount", PrintTableAggregate::Sum); }).find("nope") != std::string::npos);
+
+    // The aggregates are typed numbers, and pairs without a value are null rather than empty
+    CHECK(sums.IsNumericColumn(1) && sums.IsNumericColumn(2) && sums.IsNull(1, 2) && !sums.IsNull(0, 2));
+    CHECK(counts.columns[1].typedStorage && counts.columns[1].type == PrintTableColumnType::Integer);
+    CHECK(Printed(sums).find("12.5") != std::string::npos);
+
+    // Rows with a null key are left out instead of making a row or column of the null text
+    PrintTable nullKeys;
+    nullKeys.SetTitle("Keys");
+    nullKeys.AddColumn("region");
+    nullKeys.AddColumn("quarter");
+    nullKeys.AddColumn("amount");
+    nullKeys.SetNullMarker("NA");
+    nullKeys.AddRows({ { "eu", "q1", "1" }, { "NA", "q1", "2" }, { "eu", "NA", "3" }, { "-", "-", "4" } });
+    PrintTable pivoted = PrintTable::Pivot(nullKeys, "region", "quarter", "amount", PrintTableAggregate::Sum);
+    CHECK(pivoted.NumRows() == 2 && pivoted.NumColumns() == 3);
+    CHECK(pivoted.ColumnName(1) == "-" && pivoted.ColumnName(2) == "q1");
+    CHECK(pivoted.Cell(0, 0) == "eu" && pivoted.Cell(0, 2) == "1" && pivoted.IsNull(0, 1));
+    CHECK(pivoted.Cell(1, 0) == "-" && pivoted.Cell(1, 1) == "4" && pivoted.IsNull(1, 2));
+}
+
+static void TestWindowColumns()
+{
+    PrintTable table;
+    table.SetTitle("Requests");
+    table.AddColumn("host");
+    table.AddColumn("count");
+    table.AddWindowColumn("total", PrintTableWindow::RunningSum, "count", "", "host");
+    table.AddWindowColumn("delta", PrintTableWindow::Delta, "count");
+    table.AddWindowColumn("rank", PrintTableWindow::Rank, "count", "", "host");
+    table.AddRow({ "a", "5" });
+    table.AddRow({ "b", "3" });
+    table.AddRow({ "a", "7" });
+    table.AddRow({ "b", "1" });
+    CHECK(table.NumColumns() == 5 && table.ColumnName(2) == "total");
+    // Running sums and ranks are per host, deltas over all rows in the order they were added
+    CHECK(table.Cell(0, 2) == "5" && table.Cell(1, 2) == "3" && table.Cell(2, 2) == "12" && table.Cell(3, 2) == "4");
+    CHECK(table.Cell(1, 3) == "-2" && table.Cell(2, 3) == "4" && table.Cell(3, 3) == "-6");
+    CHECK(table.Cell(0, 4) == "2" && table.Cell(1, 4) == "1" && table.Cell(2, 4) == "1" && table.Cell(3, 4) == "2");
+
+    // Changing a value recomputes the column
+    table.SetCell(0, 1, "10");
+    CHECK(table.Cell(2, 2) == "17" && table.Cell(0, 4) == "1");
+    CHECK(Printed(table).find(" 17 |") != std::string::npos);
+    // Widths are kept up to date as values are appended and recomputed, without formatting every row again
+    CHECK(table.computedColumns[0].maxCellWidth == 2 && table.computedColumns[1].maxCellWidth == 2);
+    table.AddRow({ "a", "1000" });
+    CHECK(table.computedColumns[0].maxCellWidth == 4 && table.Cell(4, 2) == "1017");
+    // Computed columns can be filtered on like stored ones
+    CHECK(table.Query("select host where total > 10 and delta > 0").rowSources == std::vector<size_t>({ 2, 4 }));
+    CHECK(table.Query("select host where delta < 0").rowSources == std::vector<size_t>({ 1, 3 }));
+    CHECK(Captured([&]() { table.AddWindowColumn("x", PrintTableWindow::Rank, "nope"); }).find("nope") != std::string::npos);
+}
+
+static void TestVisualColumns()
+{
+    PrintTable table;
+    table.SetTitle("Load");
+    table.AddColumn("host");
+    table.AddColumn("load");
+    table.AddVisualColumn("bar", PrintTableVisual::Bar, "load", 4);
+    table.AddVisualColumn("trend", PrintTableVisual::Sparkline, "load", 3);
+    table.AddRow({ "a", "0" });
+    table.AddRow({ "b", "2" });
+    table.AddRow({ "c", "4" });
+    table.AddRow({ "d", "-" });
+    // Bars are scaled between the min and max of the column, sparklines show the last values up to the row
+    CHECK(table.Cell(0, 2) == "    " && table.Cell(1, 2) == "██  " && table.Cell(2, 2) == "████");
+    CHECK(table.Cell(2, 3) == "▁▅█" && table.Cell(0, 3) == "  ▁");
+    CHECK(table.Cell(3, 2) == "    " && table.Cell(3, 3) == "▅█ ");
+    // Block characters take up one column each
+    CHECK(table.CellWidth(2, 2) == 4 && table.CellWidth(2, 3) == 3);
+    CHECK(Printed(table).find("| ████ |") != std::string::npos);
+    // Views pad visuals by their width rather than their bytes
+    std::string rendered;
+    table.Query("select host, trend, bar where host != \"a\"").Render(rendered);
+    CHECK(rendered.find("|  b   |   ▁▅  | ██   |") != std::string::npos && rendered.find("|  c   |  ▁▅█  | ████ |") != std::string::npos);
+}
+
+static void TestColumnStats()
+{
+    CHECK(PrintTableLeadingZeros(0) == 64 && PrintTableLeadingZeros(1) == 63 && PrintTableLeadingZeros(uint64_t(1) << 63) == 0);
+
+    PrintTable table;
+    AddJobColumns(table);
+    table.EnableColumnStats(2);
+    for (int i = 0; i < 50000; i++)
+    {
+        table.AddRow({ std::to_string(i), "h" + std::to_string(i % 1000), i % 10 == 0 ? "failed" : i % 10 < 4 ? "running" : "ok" });
+    }
+    PrintTable summary = table.Summary();
+    CHECK(summary.NumRows() == 3 && summary.Cell(2, 0) == "status");
+    // Distinct counts are within a few percent
+    const double jobs = std::stod(summary.Cell(0, 1));
+    const double hosts = std::stod(summary.Cell(1, 1));
+    CHECK(jobs > 47000 && jobs < 53000);
+    CHECK(hosts > 950 && hosts < 1050);
+    CHECK(summary.Cell(2, 1) == "3");
+    CHECK(summary.Cell(2, 2) == "ok (30000), running (15000)");
+
+    PrintTable plain;
+    AddJobColumns(plain);
+    CHECK(Captured([&]() { plain.Summary(); }).find("call EnableColumnStats first") != std::string::npos);
+}
+
+static void TestTypeInference()
+{
+    PrintTable table;
+    table.SetTitle("Types");
+    table.AddColumn("int");
+    table.AddColumn("decimal");
+    table.AddColumn("date");
+    table.AddColumn("level");
+    table.AddColumn("text");
+    std::vector<std::vector<std::string>> rows;
+    for (int i = 0; i < 8; i++)
+    {
+        rows.push_back({ std::to_string(i * 1000 - 3000), std::to_string(i) + ".25", "2024-01-0" + std::to_string(i + 1) + " 12:00", i % 2 == 0 ? "info" : "warn", "row " + std::to_string(i) });
+    }
+    table.AddRows(rows);
+    CHECK(table.columns[0].type == PrintTableColumnType::Integer && table.columns[0].typedStorage);
+    CHECK(table.columns[1].type == PrintTableColumnType::Decimal && table.columns[1].typedStorage && table.columns[1].scale == 2);
+    CHECK(table.columns[2].type == PrintTableColumnType::Timestamp);
+    CHECK(table.columns[3].type == PrintTableColumnType::Enum);
+    CHECK(table.columns[4].type == PrintTableColumnType::Text);
+    CHECK(table.IsNumericColumn(0) && table.IsNumericColumn(1) && !table.IsNumericColumn(4));
+    // Typed cells are written back exactly as they were added
+    CHECK(table.Cell(0, 0) == "-3000" && table.Cell(7, 1) == "7.25");
+
+    // A cell that does not fit the typed storage moves the column back to text without losing the other cells
+    table.AddRow({ "n/a", "1.50", "x", "info", "y" });
+    CHECK(!table.columns[0].typedStorage && table.columns[0].type == PrintTableColumnType::Text);
+    CHECK(table.Cell(1, 0) == "-2000" && table.Cell(8, 0) == "n/a");
+    CHECK(table.columns[1].typedStorage && table.Cell(8, 1) == "1.50");
+
+    // Only a sign, digits and a fraction make a number, anything else strtod would read stays text
+    PrintTable strict;
+    strict.SetTitle("Strict");
+    strict.AddColumn("v");
+    strict.AddColumn("w");
+    strict.AddRows({ { "inf", "+3" }, { "nan", "0.5" }, { "0x10", "12" }, { " 7", "-4.25" }, { "1e3", "007" }, { "9", "1." } });
+    CHECK(!strict.IsNumericColumn(0) && strict.columns[0].type != PrintTableColumnType::Decimal);
+    CHECK(strict.columns[1].type == PrintTableColumnType::Text);
+    CHECK(strict.Query("select * where v > 5").rowSources == std::vector<size_t>({ 5 }));
+    CHECK(strict.Query("select * where w > 0").rowSources == std::vector<size_t>({ 0, 1, 2, 4 }));
+}
+
+static void TestNulls()
+{
+    PrintTable table;
+    AddJobColumns(table);
+    table.SetNullMarker("NA");
+    table.AddRows({ { "1", "NA", "ok" }, { "2", "h2", "NA" }, { "3", "h3", "ok" } });
+    CHECK(table.IsNull(0, 1) && table.IsNull(1, 2) && !table.IsNull(0, 0));
+    CHECK(table.Cell(0, 1) == "-" && table.Cell(1, 1) == "h2");
+    CHECK(table.columns[1].nullCount == 1);
+
+    // Nulls are printed with the null text, and do not keep the rest of their column from being typed
+    table.SetNullText("<none>");
+    CHECK(table.Cell(0, 1) == "<none>");
+    CHECK(Printed(table).find("<none>") != std::string::npos);
+    CHECK(table.columns[0].typedStorage);
+
+    // Cells can change between null and not null in both directions
+    table.SetNull(2, 0);
+    table.SetCell(0, 1, "h1");
+    table.SetCell(1, 2, "NA");
+    CHECK(table.IsNull(2, 0) && !table.IsNull(0, 1) && table.IsNull(1, 2));
+    CHECK(table.Cell(0, 1) == "h1" && table.Cell(1, 0) == "2" && table.Cell(2, 1) == "h3");
+    CHECK(table.columns[0].nullCount == 1 && table.columns[1].nullCount == 0);
+    CHECK(table.Query("select job where host = \"h1\"").rowSources == std::vector<size_t>({ 0 }));
+    // Nulls of typed and text columns never satisfy a comparison, and sort last in either direction
+    CHECK(table.Query("select * where job >= 1").rowSources == std::vector<size_t>({ 0, 1 }));
+    CHECK(table.Query("select * where job != 2").rowSources == std::vector<size_t>({ 0 }));
+    CHECK(table.Query("select * where status = \"ok\"").rowSources == std::vector<size_t>({ 0, 2 }));
+    CHECK(table.Query("select * order by job desc").rowSources == std::vector<size_t>({ 1, 0, 2 }));
+}
+
+static void TestTimestampsAndDurations()
+{
+    PrintTable table;
+    table.SetTitle("Events");
+    table.AddTimestampColumn("utc", 3);
+    table.AddTimestampColumn("local", 0, 120);
+    table.AddDurationColumn("took");
+    table.AddRow({ "1700000000123456789", "1700000000123456789", "999" });
+    table.AddRow({ "0", "-1", "1500" });
+    table.AddRow({ "86400000000000", "86400000000000", "2500000000" });
+    table.AddRow({ "1", "1", "12345678" });
+    CHECK(table.columns[0].type == PrintTableColumnType::Timestamp && table.columns[2].type == PrintTableColumnType::Duration);
+    CHECK(table.Cell(0, 0) == "2023-11-14 22:13:20.123" && table.Cell(0, 1) == "2023-11-15 00:13:20");
+    // Times before the epoch and across days, in the time zone of the column
+    CHECK(table.Cell(1, 1) == "1970-01-01 01:59:59" && table.Cell(2, 0) == "1970-01-02 00:00:00.000");
+    CHECK(table.Cell(0, 2) == "999ns" && table.Cell(1, 2) == "1.50us" && table.Cell(2, 2) == "2.50s" && table.Cell(3, 2) == "12.35ms");
+    CHECK(table.IsNumericColumn(2));
+
+    // A cell that is not a number of nanoseconds is kept as text
+    table.AddRow({ "1", "soon", "1" });
+    CHECK(table.Cell(4, 1) == "soon" && table.Cell(4, 0) == "1970-01-01 00:00:00.000");
+}
+
+static void TestSpilling()
+{
+    PrintTable table;
+    AddJobColumns(table);
+    PrintTable resident;
+    AddJobColumns(resident);
+    table.SetMemoryBudget(64 << 10);
+    std::vector<std::vector<std::string>> rows;
+    for (int i = 0; i < 30000; i++)
+    {
+        rows.push_back({ std::to_string(i), "host-" + std::to_string(i % 977), i % 3 == 0 ? "ok" : "failed" });
+    }
+    table.AddRows(rows);
+    resident.AddRows(rows);
+    CHECK(table.sealedRows >= 5 * PRINT_TABLE_CHUNK_ROWS);
+    // All columns of a chunk share one mapping of the spill file
+    for (size_t i = 0; i < table.columns[0].sealedChunks.size(); i++)
+    {
+        const std::shared_ptr<PrintTableSpillMapping>& mapping = table.columns[0].sealedChunks[i].mapping;
+        CHECK(mapping && mapping == table.columns[1].sealedChunks[i].mapping && mapping == table.columns[2].sealedChunks[i].mapping);
+    }
+    CHECK(table.Cell(1, 1) == "host-1" && table.Cell(4097, 0) == "4097");
+    CHECK(Printed(table) == Printed(resident));
+    CHECK(Captured([&]() { table.SetCell(0, 2, "x"); }).find("can no longer be changed") != std::string::npos);
+}
+
+static void TestResetAndReprint()
+{
+    PrintTable table;
+    AddJobColumns(table);
+    table.AddRow({ "1", "h1", "ok" });
+    table.AddRow({ "2", "h2", "failed" });
+    const std::string expected = Printed(table);
+
+    // The same content added after a Reset is formatted again, since Reset dropped the format data
+    table.Reset();
+    CHECK(Captured([&]() { table.Print(); }).find("Missing some necessary data") != std::string::npos);
+    AddJobColumns(table);
+    table.AddRow({ "1", "h1", "ok" });
+    table.AddRow({ "2", "h2", "failed" });
+    CHECK(Printed(table) == expected);
+
+    // Rows spread over several chunks are formatted chunk by chunk, and only changed chunks again
+    table.Reset();
+    AddJobColumns(table);
+    PrintTable copy;
+    AddJobColumns(copy);
+    for (size_t i = 0; i < 3 * PRINT_TABLE_CHUNK_ROWS; i++)
+    {
+        table.AddRow({ std::to_string(i), "h", "ok" });
+    }
+    Printed(table);
+    table.SetCell(5000, 2, "a much longer status");
+    for (size_t i = 0; i < 3 * PRINT_TABLE_CHUNK_ROWS; i++)
+    {
+        copy.AddRow({ std::to_string(i), "h", i == 5000 ? "a much longer status" : "ok" });
+    }
+    CHECK(Printed(table) == Printed(copy));
+}
+
+static void TestCompression()
+{
+    PrintTable table;
+    AddJobColumns(table);
+    PrintTable resident;
+    AddJobColumns(resident);
+    std::vector<std::vector<std::string>> rows;
+    for (int i = 0; i < 5 * int(PRINT_TABLE_CHUNK_ROWS); i++)
+    {
+        rows.push_back({ std::to_string(i * 3), "host-" + std::to_string(i * 7919LL % 100003), i % 3 == 0 ? "ok" : "failed" });
+    }
+    table.AddRows(rows);
+    resident.AddRows(rows);
+    table.EnableCompression(PRINT_TABLE_CHUNK_ROWS);
+    CHECK(table.sealedRows == 4 * PRINT_TABLE_CHUNK_ROWS);
+    // Numbers are delta encoded, few distinct texts dictionary encoded and distinct texts stored plain
+    CHECK(PrintTableChunkEncoding((*table.columns[0].sealedChunks[0].compressed)[0]) == PrintTableChunkEncoding::Delta);
+    CHECK(PrintTableChunkEncoding((*table.columns[1].sealedChunks[0].compressed)[0]) == PrintTableChunkEncoding::Plain);
+    CHECK(PrintTableChunkEncoding((*table.columns[2].sealedChunks[0].compressed)[0]) == PrintTableChunkEncoding::Dictionary);
+    CHECK(table.columns[2].sealedChunks[0].compressed->length() < 1024);
+    CHECK(table.Cell(4097, 1) == resident.Cell(4097, 1) && table.Cell(12000, 2) == resident.Cell(12000, 2));
+    CHECK(Printed(table) == Printed(resident));
+
+    // 2048 distinct texts of 3 bytes, each twice: their codes take up more than the 1 byte lengths of plain text save
+    PrintTable codes;
+    codes.SetTitle("Codes");
+    codes.AddColumn("code");
+    char code[8];
+    for (size_t i = 0; i < 2 * PRINT_TABLE_CHUNK_ROWS; i++)
+    {
+        snprintf(code, sizeof(code), "%03x", unsigned(i % 2048));
+        codes.AddRow({ code });
+    }
+    codes.EnableCompression(PRINT_TABLE_CHUNK_ROWS);
+    CHECK(PrintTableChunkEncoding((*codes.columns[0].sealedChunks[0].compressed)[0]) == PrintTableChunkEncoding::Plain);
+    CHECK(codes.Cell(2049, 0) == "001");
+}
+
+static void TestLogReplay()
+{
+    const std::string path = "/tmp/printTableTest" + std::to_string(getpid()) + ".log";
+    unlink(path.c_str());
+    std::string expected;
+    {
+        PrintTable table;
+        AddJobColumns(table);
+        table.SetNullMarker("");
+        CHECK(table.OpenLog(path, 2));
+        table.AddRows({ { "1", "h1", "ok" }, { "2", "", "failed" } });
+        for (int i = 3; i < 6000; i++)
+        {
+            table.AddRow({ std::to_string(i), "h" + std::to_string(i % 7), "ok" });
+        }
+        table.SetCell(1, 1, "h2");
+        table.SetNull(0, 2);
+        expected = Printed(table);
+    }
+
+    // The table is rebuilt from the log alone, with its types, nulls and changed cells
+    {
+        PrintTable replayed;
+        CHECK(replayed.OpenLog(path));
+        CHECK(replayed.NumRows() == 5999 && replayed.title == "Jobs");
+        CHECK(replayed.columns[0].typedStorage && replayed.IsNull(0, 2) && replayed.Cell(1, 1) == "h2");
+        CHECK(Printed(replayed) == expected);
+        // It keeps logging
+        replayed.AddRow({ "6000", "h0", "ok" });
+    }
+    {
+        PrintTable reopened;
+        CHECK(reopened.OpenLog(path) && reopened.NumRows() == 6000);
+    }
+
+    // A record cut short by a crash is dropped along with everything after it
+    struct stat status;
+    CHECK(stat(path.c_str(), &status) == 0 && truncate(path.c_str(), status.st_size - 3) == 0);
+    PrintTable crashed;
+    CHECK(crashed.OpenLog(path) && crashed.NumRows() == 5999);
+    CHECK(Printed(crashed) == expected);
+    unlink(path.c_str());
+}
+
+static void TestPublish()
+{
+    const std::string name = "/printTableTest" + std::to_string(getpid());
+    PrintTable table;
+    table.SetTitle("Ids");
+    table.AddColumn("id");
+    CHECK(table.Publish(name, 64 << 10));
+    // A block per row takes up more than the segment holds, all rows in one block do not
+    char id[16];
+    for (int i = 0; i < 3000; i++)
+    {
+        snprintf(id, sizeof(id), "id%05d", i);
+        table.AddRow({ id });
+    }
+    CHECK(table.publication && table.publication->publishedRows == 3000);
+    CHECK(Captured([&]() { PrintTable::PrintPublished(name); }) == Printed(table));
+
+    // Rows that do not fit even then are left out, and the table stays published
+    for (int i = 3000; i < 6000; i++)
+    {
+        snprintf(id, sizeof(id), "id%05d", i);
+        table.AddRow({ id });
+    }
+    CHECK(!table.PublishRows() && table.publication && table.publication->publishedRows < 6000);
+    CHECK(Captured([&]() { PrintTable::PrintPublished(name); }).find("id02999") != std::string::npos);
+    table.Reset();
+    CHECK(Captured([&]() { PrintTable::PrintPublished(name); }).find("No table is published") != std::string::npos);
+
+    PrintTable large;
+    large.SetTitle("Large");
+    large.AddColumn("text");
+    large.AddRow({ std::string(8192, 'x') });
+    CHECK(Captured([&]() { CHECK(!large.Publish(name, 4096)); }).find("does not fit") != std::string::npos);
+
+    // A name that is already published is not taken over, and stays published until its owner lets go of it
+    PrintTable owner;
+    owner.SetTitle("Owner");
+    owner.AddColumn("id");
+    owner.AddRow({ "mine" });
+    CHECK(owner.Publish(name, 64 << 10));
+    CHECK(owner.Publish(name, 64 << 10));
+    CHECK(Captured([&]() { CHECK(!large.Publish(name)); }).find("already exists") != std::string::npos);
+    CHECK(!large.publication && Captured([&]() { PrintTable::PrintPublished(name); }).find("mine") != std::string::npos);
+    owner.Reset();
+    CHECK(large.Publish(name));
+}
+
+// Sends a request line to the server at path and returns the response, polling the server while waiting for it
+static std::string Request(PrintTableServer& server, const std::string& path, const std::string& request)
+{
+    const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    std::string response;
+    if (connect(fd, (const sockaddr*)&address, sizeof(address)) == 0 && write(fd, request.data(), request.length()) == ssize_t(request.length()))
+    {
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+        char buffer[4096];
+        for (int polls = 0; polls < 1000; polls++)
+        {
+            server.Poll(1);
+            const ssize_t length = read(fd, buffer, sizeof(buffer));
+            if (length == 0)
+            {
+                break;
+            }
+            if (length > 0)
+            {
+                response.append(buffer, length);
+            }
+        }
+    }
+    close(fd);
+    return response;
+}
+
+static void TestServer()
+{
+    const std::string path = "/tmp/printTableTest" + std::to_string(getpid()) + ".sock";
+    PrintTable table;
+    AddJobColumns(table);
+    table.AddRows({ { "1", "h1", "ok" }, { "2", "h2", "failed" }, { "3", "h1", "failed" } });
+    PrintTableServer server;
+    CHECK(server.Listen(path));
+    server.Register("jobs", table);
+
+    CHECK(Request(server, path, "jobs\n") == Printed(table));
+    CHECK(Request(server, path, "jobs\tquery=select job where status = \"failed\"\tformat=csv\n") == "job\n2\n3\n");
+    CHECK(Request(server, path, "jobs\tgrep=h1\trows=1:5\tformat=csv\n") == "job,host,status\n3,h1,failed\n");
+    CHECK(Request(server, path, "nope\n") == "No table named 'nope' is served.\n");
+    CHECK(Request(server, path, "jobs\tcolor=red\n") == "Unknown option 'color=red'.\n");
+
+    // An invalid query is reported to the client, and nothing is printed by the server
+    std::string response;
+    CHECK(Captured([&]() { response = Request(server, path, "jobs\tquery=select job where\n"); }).empty());
+    CHECK(response == "Invalid query on table 'Jobs': expected a column name at position 16.\n");
+    server.Close();
+}
+
+static void TestMerge()
+{
+    PrintTable first;
+    AddJobColumns(first);
+    first.SetNullMarker("");
+    first.AddRows({ { "1", "h1", "ok" }, { "4", "", "failed" }, { "6", "h6", "ok" } });
+    PrintTable second;
+    AddJobColumns(second);
+    second.SetNullMarker("");
+    second.AddRows({ { "2", "h2", "" }, { "5", "h5", "ok" } });
+    std::vector<std::string> parts(2);
+    first.Serialize(parts[0]);
+    second.Serialize(parts[1]);
+
+    PrintTable concatenated = PrintTable::Merge(parts);
+    CHECK(concatenated.NumRows() == 5 && concatenated.Cell(3, 0) == "2" && concatenated.IsNull(1, 1) && concatenated.IsNull(3, 2));
+    PrintTable merged = PrintTable::Merge(parts, "job");
+    CHECK(merged.NumRows() == 5);
+    for (size_t r = 0; r < merged.NumRows(); r++)
+    {
+        CHECK(merged.Cell(r, 0) == std::string("12456").substr(r, 1));
+    }
+    CHECK(merged.Cell(1, 1) == "h2" && merged.IsNull(1, 2) && merged.IsNull(2, 1) && merged.Cell(3, 1) == "h5");
+
+    // A part whose validity bits do not agree with its null count is left out
+    PrintTable nulls;
+    nulls.SetTitle("Nulls");
+    nulls.AddColumn("v");
+    nulls.SetNullMarker("");
+    nulls.AddRows({ { "a" }, { "" }, { "c" } });
+    std::vector<std::string> malformed(2);
+    nulls.Serialize(malformed[0]);
+    nulls.Serialize(malformed[1]);
+    // The part ends with the null count, one byte of validity bits and two values of one byte and their lengths
+    CHECK(malformed[1][malformed[1].length() - 5] == 5);
+    malformed[1][malformed[1].length() - 5] = 7;
+    PrintTable result;
+    CHECK(Captured([&]() { result = PrintTable::Merge(malformed); }).find("Part 1 cannot be merged") != std::string::npos);
+    CHECK(result.NumRows() == 3 && result.IsNull(1, 0));
+}
+
+static void TestSharedBlocks()
+{
+    PrintTable table;
+    AddJobColumns(table);
+    for (size_t i = 0; i < 3 * PRINT_TABLE_CHUNK_ROWS; i++)
+    {
+        table.AddRow({ "job-" + std::to_string(i), "h" + std::to_string(i % 5), i % 4 == 0 ? "failed" : "ok" });
+    }
+    const std::string expected = Printed(table);
+    PrintTable copy = table;
+    CHECK(copy.columns[1].cells.blocks.size() == 3 && copy.columns[1].cells.blocks[2] == table.columns[1].cells.blocks[2]);
+    CHECK(copy.chunks[0].rowStrs == table.chunks[0].rowStrs);
+
+    // Columns that span several blocks are read in place instead of copied
+    PrintTableCowVector<std::string> scratch;
+    CHECK(&PrintTableColumnCells(copy, 1, scratch) == &copy.columns[1].cells && scratch.Empty());
+    CHECK(copy.Query("select job where host = \"h3\" order by status desc limit 2").rowSources == std::vector<size_t>({ 3, 13 }));
+    CHECK(copy.Range("host", "h3", "h4").NumRows() == 2 * 2457);
+    PrintTable pivot = PrintTable::Pivot(copy, "host", "status", "job", PrintTableAggregate::Count);
+    CHECK(pivot.NumRows() == 5 && pivot.Cell(0, 0) == "h0");
+    copy.AddWindowColumn("rank", PrintTableWindow::Rank, "job", "status", "host");
+    CHECK(copy.NumColumns() == 4);
+
+    // Reading left the blocks shared, and changing a cell copies only its block
+    CHECK(copy.columns[1].cells.blocks[0] == table.columns[1].cells.blocks[0]);
+    copy.SetCell(5, 1, "changed");
+    CHECK(copy.columns[1].cells.blocks[0] != table.columns[1].cells.blocks[0] && copy.columns[1].cells.blocks[1] == table.columns[1].cells.blocks[1]);
+    CHECK(table.Cell(5, 1) == "h0" && Printed(table) == expected);
+}
+
+static void TestFreeze()
+{
+    PrintTable table;
+    AddJobColumns(table);
+    table.SetNullMarker("");
+    std::vector<std::vector<std::string>> rows;
+    for (int i = 0; i < 10000; i++)
+    {
+        rows.push_back({ std::to_string(i), i % 10 == 3 ? "" : "host-" + std::to_string(i * 7919LL % 100003), i % 3 == 0 ? "ok" : "failed" });
+    }
+    table.AddRows(rows);
+    const std::string expected = Printed(table);
+    const std::vector<size_t> grepped = table.Grep("host-12").rowSources;
+    table.Freeze();
+    CHECK(table.frozen);
+    // Few distinct statuses are dictionary encoded, the hosts are not
+    CHECK(!table.columns[2].frozen->codes.empty() && table.columns[1].frozen->codes.empty());
+    CHECK(table.columns[1].cells.Empty() && table.columns[0].numbers.Empty());
+    CHECK(table.Cell(3, 1) == "-" && table.IsNull(3, 1) && table.Cell(4, 2) == "failed");
+    CHECK(Printed(table) == expected);
+    CHECK(table.Grep("host-12").rowSources == grepped);
+    CHECK(table.Grep("ok", { "status" }).NumRows() == 3334);
+    CHECK(Captured([&]() { table.AddRow({ "x", "y", "z" }); }).find("is frozen") != std::string::npos && table.NumRows() == 10000);
+    CHECK(Captured([&]() { table.SetCell(0, 0, "x"); }).find("is frozen") != std::string::npos && table.Cell(0, 0) == "0");
+
+    // Copies share the frozen cells
+    PrintTable copy = table;
+    CHECK(copy.columns[1].frozen == table.columns[1].frozen && Printed(copy) == expected);
+}
+
+static PrintTable* emergencyTable = nullptr;
+
+static void PrintEmergencyTable(int)
+{
+    emergencyTable->PrintEmergency();
+}
+
+static std::string Raised()
+{
+    return Captured([]() { raise(SIGUSR1); });
+}
+
+static void TestEmergencyPrint()
+{
+    PrintTable table;
+    emergencyTable = &table;
+    signal(SIGUSR1, PrintEmergencyTable);
+    CHECK(table.ArmEmergencyPrint(1));
+    CHECK(Raised().empty());
+    AddJobColumns(table);
+    table.AddColumn("load");
+    table.AddRow({ "1", "h1", "ok", "3" });
+    table.AddRow({ "2", "h2", "failed", "5" });
+    CHECK(Raised() == Printed(table));
+
+    // Every change to the layout or the cells shows up in the render
+    table.AddColumnGroup("Where", 1, 2);
+    CHECK(Raised() == Printed(table));
+    table.AddWindowColumn("total", PrintTableWindow::RunningSum, "load");
+    CHECK(Raised() == Printed(table));
+    table.AddVisualColumn("bar", PrintTableVisual::Bar, "load", 4);
+    CHECK(Raised() == Printed(table));
+    table.SetCell(0, 2, "running");
+    table.SetCell(1, 1, "h3");
+    CHECK(Raised() == Printed(table));
+    table.SetNullText("?");
+    table.SetNull(1, 3);
+    CHECK(Raised() == Printed(table));
+
+    // The table stays armed across a reset
+    table.Reset();
+    CHECK(Raised().empty());
+    AddJobColumns(table);
+    table.AddRow({ "3", "h9", "ok" });
+    CHECK(!Raised().empty() && Raised() == Printed(table));
+    signal(SIGUSR1, SIG_DFL);
+}
+
+int main()
+{
+    TestColumnGroups();
+    TestJoin();
+    TestDiff();
+    TestFingerprint();
+    TestGrep();
+    TestTrigramIndex();
+    TestIndexes();
+    TestQuery();
+    TestPivot();
+    TestWindowColumns();
+    TestVisualColumns();
+    TestColumnStats();
+    TestTypeInference();
+    TestNulls();
+    TestTimestampsAndDurations();
+    TestSpilling();
+    TestResetAndReprint();
+    TestCompression();
+    TestLogReplay();
+    TestPublish();
+    TestServer();
+    TestMerge();
+    TestSharedBlocks();
+    TestFreeze();
+    TestEmergencyPrint();
+    if (failures > 0)
+    {
+        printf("%d checks failed.\n", failures);
+        return 1;
+    }
+    printf("All tests passed.\n");
+    return 0;
+}